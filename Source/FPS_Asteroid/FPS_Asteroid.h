@@ -4,6 +4,9 @@
 
 #include "CoreMinimal.h"
 
+// project gameplay stats, use "stat FPSAsteroid" to show
+DECLARE_STATS_GROUP(TEXT("FPSAsteroid"), STATGROUP_FPSAsteroid, STATCAT_Advanced);
+
 #define TRACE_DIST_MAX     1'000'00.f  // 1km, project line trace distance soft limitation
 
 // used to disable all draw debug
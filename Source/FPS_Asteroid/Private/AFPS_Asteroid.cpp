@@ -4,11 +4,22 @@
 #include "AFPS_Asteroid.h"
 
 #include <FPS_Asteroid/Public/Components/AFPS_HealthComponent.h>
+#include <FPS_Asteroid/Public/Components/AFPS_AsteroidPoolComponent.h>
+#include <FPS_Asteroid/Public/Components/AFPS_AsteroidSpinComponent.h>
+#include <FPS_Asteroid/Public/AFPS_GameMode.h>
 #include "Engine/CollisionProfile.h"
+#include "GameFramework/DamageType.h"
 
 // Sets default values
 AAFPS_Asteroid::AAFPS_Asteroid()
 {
+	LiveAsteroidIndex = INDEX_NONE;
+	SpawnedAsteroidIndex = INDEX_NONE;
+	LastHitTime = 0.f;
+	Significance = EAsteroidSignificance::High;
+	bInPool = false;
+	bDying = false;
+
 	// create mesh
 	MeshComp = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Mesh"));
 	MeshComp->SetCollisionProfileName(UCollisionProfile::PhysicsActor_ProfileName);
@@ -17,6 +28,7 @@ AAFPS_Asteroid::AAFPS_Asteroid()
 	// health component
 	HealthComp = CreateDefaultSubobject<UAFPS_HealthComponent>(TEXT("Health"));
 	HealthComp->OnHealthChanged.AddDynamic(this, &AAFPS_Asteroid::OnHealthChanged);
+	HealthComp->SetKillCategory(EKillVictimCategory::Asteroid);
 
 	// mesh find
 	static ConstructorHelpers::FObjectFinder<UStaticMesh> MeshFinder(TEXT("/Game/FPSAsteroid/SM_Rock.SM_Rock"));
@@ -36,13 +48,76 @@ AAFPS_Asteroid::AAFPS_Asteroid()
 	}
 }
 
+void AAFPS_Asteroid::BeginPlay()
+{
+	Super::BeginPlay();
+
+	LastHitTime = GetWorld()->GetTimeSeconds();
+
+	// any asteroid on scene is registered, not only spawned by asteroid spawner
+	if (AAFPS_GameMode* GM = GetWorld()->GetAuthGameMode<AAFPS_GameMode>())
+	{
+		// game mode spins asteroid, body is used only for collision
+		if (GM->GetAsteroidSpin())
+		{
+			MeshComp->SetSimulatePhysics(false);
+		}
+
+		GM->RegisterLiveAsteroid(this);
+	}
+}
+
+void AAFPS_Asteroid::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (AAFPS_GameMode* GM = GetWorld()->GetAuthGameMode<AAFPS_GameMode>())
+	{
+		GM->UnregisterLiveAsteroid(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+float AAFPS_Asteroid::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
+{
+	const float ActualDamage = Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
+
+	// any point damage source (weapon, damage queue, blueprint ApplyPointDamage) spins asteroid,
+	// released or destroyed asteroid is not registered and ignores impulse
+	if (ActualDamage != 0.f && DamageEvent.IsOfType(FPointDamageEvent::ClassID) && !MeshComp->IsSimulatingPhysics())
+	{
+		AAFPS_GameMode* GM = GetWorld()->GetAuthGameMode<AAFPS_GameMode>();
+		if (UAFPS_AsteroidSpinComponent* AsteroidSpin = GM ? GM->GetAsteroidSpin() : nullptr)
+		{
+			const FPointDamageEvent& PointDamageEvent = static_cast<const FPointDamageEvent&>(DamageEvent);
+			const UDamageType* DamageTypeCDO = DamageEvent.DamageTypeClass ? DamageEvent.DamageTypeClass->GetDefaultObject<UDamageType>() : GetDefault<UDamageType>();
+			AsteroidSpin->AddImpulseAtLocation(this, PointDamageEvent.ShotDirection * DamageTypeCDO->DamageImpulse, PointDamageEvent.HitInfo.ImpactPoint);
+		}
+	}
+
+	return ActualDamage;
+}
+
 void AAFPS_Asteroid::OnHealthChanged(UAFPS_HealthComponent* InHealthComp, float Health, float HealthDelta, const UDamageType* DamageType, AController* InstigatedBy, AActor* DamageCauser)
 {
+	// body may be put to sleep by physics LOD, hit wakes it even without impulse
+	LastHitTime = GetWorld()->GetTimeSeconds();
+	MeshComp->WakeRigidBody();
+
 	if (InHealthComp)
 	{
 		if (InHealthComp->IsDead())
 		{
-			OnAsteroidDeath();
+			// blueprint event plays fx only, it can't skip pool release, fx over significance budget is skipped
+			AAFPS_GameMode* GM = GetWorld()->GetAuthGameMode<AAFPS_GameMode>();
+			UAFPS_AsteroidSignificanceComponent* AsteroidSignificance = GM ? GM->GetAsteroidSignificance() : nullptr;
+			if (AsteroidSignificance == nullptr || AsteroidSignificance->TryAddDeathFX(Significance))
+			{
+				bDying = true;
+				OnAsteroidDeath();
+				bDying = false;
+			}
+
+			FinishDeath();
 		}
 	}
 }
@@ -50,6 +125,82 @@ void AAFPS_Asteroid::OnHealthChanged(UAFPS_HealthComponent* InHealthComp, float
 void AAFPS_Asteroid::OnAsteroidDeath_Implementation()
 {
 	if (GEngine) GEngine->AddOnScreenDebugMessage(INDEX_NONE, 1.5f, FColor::Yellow, "Asteroid Is Killed");
+}
+
+void AAFPS_Asteroid::K2_DestroyActor()
+{
+	AAFPS_GameMode* GM = GetWorld()->GetAuthGameMode<AAFPS_GameMode>();
+	if (bDying && GM && GM->GetAsteroidPool())
+	{
+		return;  // FinishDeath returns asteroid to pool
+	}
 
-	Destroy();
+	Super::K2_DestroyActor();
+}
+
+void AAFPS_Asteroid::FinishDeath()
+{
+	// destroyed by blueprint death event when pool is not used
+	if (IsPendingKillPending())
+	{
+		return;
+	}
+
+	AAFPS_GameMode* GM = GetWorld()->GetAuthGameMode<AAFPS_GameMode>();
+	if (UAFPS_AsteroidPoolComponent* AsteroidPool = GM ? GM->GetAsteroidPool() : nullptr)
+	{
+		AsteroidPool->Release(this);
+	}
+	else
+	{
+		Destroy();
+	}
+}
+
+void AAFPS_Asteroid::OnReleasedToPool()
+{
+	bInPool = true;
+
+	// pooled asteroid is not alive
+	if (AAFPS_GameMode* GM = GetWorld()->GetAuthGameMode<AAFPS_GameMode>())
+	{
+		GM->UnregisterLiveAsteroid(this);
+	}
+
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+
+	MeshComp->SetSimulatePhysics(false);
+}
+
+void AAFPS_Asteroid::OnAcquiredFromPool(const FTransform& SpawnTransform)
+{
+	bInPool = false;
+
+	SetActorTransform(SpawnTransform, false, nullptr, ETeleportType::ResetPhysics);
+	HealthComp->ResetHealth();
+
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+
+	// significance is updated later, asteroid could be culled before it was killed
+	Significance = EAsteroidSignificance::High;
+	MeshComp->SetVisibility(true);
+
+	AAFPS_GameMode* GM = GetWorld()->GetAuthGameMode<AAFPS_GameMode>();
+
+	// game mode spins asteroid if analytic spin is enabled, body is used only for collision
+	if (GM == nullptr || GM->GetAsteroidSpin() == nullptr)
+	{
+		MeshComp->SetSimulatePhysics(true);
+		MeshComp->SetPhysicsLinearVelocity(FVector::ZeroVector);
+		MeshComp->SetPhysicsAngularVelocityInDegrees(FVector::ZeroVector);
+	}
+
+	LastHitTime = GetWorld()->GetTimeSeconds();
+
+	if (GM)
+	{
+		GM->RegisterLiveAsteroid(this);
+	}
 }
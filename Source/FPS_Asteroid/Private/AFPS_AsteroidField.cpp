@@ -0,0 +1,488 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AFPS_AsteroidField.h"
+
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Components/AFPS_AsteroidSpinComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/World.h"
+#include "Serialization/ArchiveCountMem.h"
+
+#include <FPS_Asteroid/FPS_Asteroid.h>
+#include <FPS_Asteroid/Public/AFPS_GameMode.h>
+#include <FPS_Asteroid/Public/AFPS_Asteroid.h>
+
+DECLARE_CYCLE_STAT(TEXT("Asteroid Field Tick"), STAT_AsteroidFieldTick, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Asteroid Field Alive Instances"), STAT_AsteroidFieldAlive, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Asteroid Field Updated Instances"), STAT_AsteroidFieldUpdated, STATGROUP_FPSAsteroid);
+DECLARE_MEMORY_STAT(TEXT("Asteroid Field Instance Data"), STAT_AsteroidFieldMemory, STATGROUP_FPSAsteroid);
+
+/** Actor memory including its components, FArchiveCountMem of actor alone counts only component pointers */
+static SIZE_T CountActorMemory(AActor* Actor)
+{
+	SIZE_T Size = FArchiveCountMem(Actor).GetMax();
+	for (UActorComponent* Component : Actor->GetComponents())
+	{
+		// exclusive size covers component owned render and physics data (e.g. instance buffers, bodies), not shared mesh
+		Size += FArchiveCountMem(Component).GetMax() + Component->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+	}
+	return Size;
+}
+
+/**
+ * AFPS.AsteroidField.Benchmark run, spans real frames so actors are measured with their whole world tick cost
+ * (analytic spin component or physics scene step and body sync), each case cost is world tick time over no asteroids baseline
+ */
+class FAsteroidFieldBenchmark
+{
+public:
+	FAsteroidFieldBenchmark(UWorld* InWorld, int32 InFrameNum, int32 InSpinningPercent)
+		: World(InWorld)
+		, FrameNum(InFrameNum)
+		, SpinningPercent(InSpinningPercent)
+		, Stream(1)
+	{
+		TickStartHandle = FWorldDelegates::OnWorldTickStart.AddRaw(this, &FAsteroidFieldBenchmark::OnWorldTickStart);
+		PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddRaw(this, &FAsteroidFieldBenchmark::OnWorldPostActorTick);
+	}
+
+	~FAsteroidFieldBenchmark()
+	{
+		FWorldDelegates::OnWorldTickStart.Remove(TickStartHandle);
+		FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	}
+
+	/** Check if benchmark world still exists, run of torn down world never finishes */
+	bool IsRunning() const { return World.IsValid(); }
+
+	/** Running benchmark, single run at time */
+	static TUniquePtr<FAsteroidFieldBenchmark> Active;
+
+private:
+	enum class EStage : uint8
+	{
+		Baseline,
+		Actors,
+		Field,
+	};
+
+	/** Frames skipped after stage setup, spawn and body creation cost is not measured */
+	static constexpr int32 WarmupFrameNum = 3;
+
+	static constexpr int32 AsteroidNums[] = { 1000, 10000 };
+
+	void OnWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+	{
+		if (InWorld == World.Get())
+		{
+			TickStartTime = FPlatformTime::Seconds();
+		}
+	}
+
+	void OnWorldPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+	{
+		if (InWorld != World.Get() || TickStartTime == 0.0)
+		{
+			return;
+		}
+
+		if (++StageFrame > WarmupFrameNum)
+		{
+			StageMs += (FPlatformTime::Seconds() - TickStartTime) * 1000.0;
+		}
+		TickStartTime = 0.0;
+
+		if (StageFrame == WarmupFrameNum + FrameNum)
+		{
+			NextStage();
+		}
+	}
+
+	void NextStage()
+	{
+		const double FrameMs = StageMs / FrameNum;
+		const int32 AsteroidNum = AsteroidNums[CaseIndex];
+
+		StageFrame = 0;
+		StageMs = 0.0;
+
+		switch (Stage)
+		{
+		case EStage::Baseline:
+			BaselineMs = FrameMs;
+			SpawnActors(AsteroidNum);
+			Stage = EStage::Actors;
+			break;
+
+		case EStage::Actors:
+			ActorsMs = FrameMs;
+			DestroyAsteroids();
+			SpawnField(AsteroidNum);
+			Stage = EStage::Field;
+			break;
+
+		case EStage::Field:
+			UE_LOG(LogTemp, Display, TEXT("[AsteroidField] %d asteroids, %d spinning: actors (%s spin) %.1f KB %.3f ms per frame, field %.1f KB %.3f ms per frame, baseline world tick %.3f ms"),
+				AsteroidNum, AsteroidNum * SpinningPercent / 100, bAnalyticSpin ? TEXT("analytic") : TEXT("physics"),
+				ActorsMemory / 1024.0, ActorsMs - BaselineMs, FieldMemory / 1024.0, FrameMs - BaselineMs, BaselineMs);
+
+			DestroyAsteroids();
+			Stage = EStage::Baseline;
+			if (++CaseIndex == UE_ARRAY_COUNT(AsteroidNums))
+			{
+				// last statement, run is deleted
+				Active.Reset();
+			}
+			break;
+		}
+	}
+
+	/** Asteroid actors, spun by game mode spin component if analytic spin is enabled, by physics otherwise */
+	void SpawnActors(int32 AsteroidNum)
+	{
+		AAFPS_GameMode* GM = World->GetAuthGameMode<AAFPS_GameMode>();
+		UAFPS_AsteroidSpinComponent* AsteroidSpin = GM ? GM->GetAsteroidSpin() : nullptr;
+		bAnalyticSpin = AsteroidSpin != nullptr;
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		const int32 SpinningNum = AsteroidNum * SpinningPercent / 100;
+
+		ActorsMemory = 0;
+		Asteroids.Reserve(AsteroidNum);
+		for (int32 It = 0; It != AsteroidNum; ++It)
+		{
+			AAFPS_Asteroid* Asteroid = World->SpawnActor<AAFPS_Asteroid>(AAFPS_Asteroid::StaticClass(),
+				FTransform(Origin + Stream.GetUnitVector() * 1'000'00.f), SpawnParams);
+			if (Asteroid == nullptr)
+			{
+				continue;
+			}
+
+			Asteroids.Add(Asteroid);
+			ActorsMemory += CountActorMemory(Asteroid);
+
+			if (It < SpinningNum)
+			{
+				const FVector Impulse = Stream.GetUnitVector() * 1000.f;
+				const FVector Location = Asteroid->GetActorLocation() + Stream.GetUnitVector() * 100.f;
+				if (AsteroidSpin)
+				{
+					AsteroidSpin->AddImpulseAtLocation(Asteroid, Impulse, Location);
+				}
+				else
+				{
+					Asteroid->GetMesh()->AddImpulseAtLocation(Impulse, Location);
+				}
+			}
+		}
+	}
+
+	void SpawnField(int32 AsteroidNum)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		Field = World->SpawnActor<AAFPS_AsteroidField>(AAFPS_AsteroidField::StaticClass(), FTransform::Identity, SpawnParams);
+		if (!Field.IsValid())
+		{
+			FieldMemory = 0;
+			return;
+		}
+
+		for (int32 It = 0; It != AsteroidNum; ++It)
+		{
+			Field->AddAsteroid(FTransform(Origin + Stream.GetUnitVector() * 1'000'00.f));
+		}
+		for (int32 It = 0, SpinningNum = AsteroidNum * SpinningPercent / 100; It != SpinningNum; ++It)
+		{
+			const FVector HitLocation = Field->GetInstanceLocation(It) + Stream.GetUnitVector() * 100.f;
+			Field->ApplyInstanceDamage(It, 1.f, Stream.GetUnitVector(), HitLocation, nullptr, nullptr);
+		}
+
+		FieldMemory = CountActorMemory(Field.Get()) + Field->GetInstanceDataAllocatedSize();
+	}
+
+	void DestroyAsteroids()
+	{
+		for (const TWeakObjectPtr<AAFPS_Asteroid>& Asteroid : Asteroids)
+		{
+			if (Asteroid.IsValid())
+			{
+				Asteroid->Destroy();
+			}
+		}
+		Asteroids.Reset();
+
+		if (Field.IsValid())
+		{
+			Field->Destroy();
+		}
+		Field.Reset();
+	}
+
+	/** Far below play area */
+	const FVector Origin = FVector(0.f, 0.f, -1'000'000'00.f);
+
+	TWeakObjectPtr<UWorld> World;
+	const int32 FrameNum;
+	const int32 SpinningPercent;
+	FRandomStream Stream;
+
+	FDelegateHandle TickStartHandle;
+	FDelegateHandle PostActorTickHandle;
+
+	EStage Stage = EStage::Baseline;
+	int32 CaseIndex = 0;
+	int32 StageFrame = 0;
+	double StageMs = 0.0;
+	double TickStartTime = 0.0;
+
+	double BaselineMs = 0.0;
+	double ActorsMs = 0.0;
+	SIZE_T ActorsMemory = 0;
+	SIZE_T FieldMemory = 0;
+	bool bAnalyticSpin = false;
+
+	TArray<TWeakObjectPtr<AAFPS_Asteroid>> Asteroids;
+	TWeakObjectPtr<AAFPS_AsteroidField> Field;
+};
+
+TUniquePtr<FAsteroidFieldBenchmark> FAsteroidFieldBenchmark::Active;
+constexpr int32 FAsteroidFieldBenchmark::WarmupFrameNum;
+constexpr int32 FAsteroidFieldBenchmark::AsteroidNums[];
+
+static FAutoConsoleCommandWithWorldAndArgs AsteroidFieldBenchmarkCmd(
+	TEXT("AFPS.AsteroidField.Benchmark"),
+	TEXT("Report memory (actor and components) and per frame world tick cost of asteroid actors, with analytic or physics spin, and instanced asteroid field at 1k and 10k asteroids. Usage: AFPS.AsteroidField.Benchmark [Frames] [SpinningPercent]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (World == nullptr || World->GetAuthGameMode<AAFPS_GameMode>() == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("[AsteroidField] Benchmark: no game mode"));
+			return;
+		}
+
+		if (FAsteroidFieldBenchmark::Active && FAsteroidFieldBenchmark::Active->IsRunning())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("[AsteroidField] Benchmark: already running"));
+			return;
+		}
+
+		const int32 FrameNum = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 100;
+		const int32 SpinningPercent = Args.Num() > 1 ? FMath::Clamp(FCString::Atoi(*Args[1]), 0, 100) : 10;
+
+		FAsteroidFieldBenchmark::Active = MakeUnique<FAsteroidFieldBenchmark>(World, FrameNum, SpinningPercent);
+	})
+);
+
+// Sets default values
+AAFPS_AsteroidField::AAFPS_AsteroidField()
+{
+	// tick is used to spin instances
+	PrimaryActorTick.bCanEverTick = true;
+
+	InstancesComp = CreateDefaultSubobject<UHierarchicalInstancedStaticMeshComponent>(TEXT("Instances"));
+	InstancesComp->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	RootComponent = InstancesComp;
+
+	// mesh find
+	static ConstructorHelpers::FObjectFinder<UStaticMesh> MeshFinder(TEXT("/Game/FPSAsteroid/SM_Rock.SM_Rock"));
+	if (MeshFinder.Succeeded())
+	{
+		InstancesComp->SetStaticMesh(MeshFinder.Object);
+	}
+
+	// defaults
+	DefaultHealth = 100.f;
+	HitSpinPerDamage = 3.f;
+}
+
+void AAFPS_AsteroidField::Tick(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AsteroidFieldTick);
+
+	Super::Tick(DeltaSeconds);
+
+	SET_DWORD_STAT(STAT_AsteroidFieldAlive, AliveInstanceNum);
+
+	// integrate instances spin, killed instances don't spin
+	if (!InstanceSpin.Integrate(DeltaSeconds))
+	{
+		return;
+	}
+
+	UpdateSpinningInstancesTransforms();
+}
+
+void AAFPS_AsteroidField::UpdateSpinningInstancesTransforms()
+{
+	int32 UpdatedNum = 0;
+	bool bMarkRenderStateDirty = false;
+
+	// still instances keep their render and physics data, each run of spinning instances is one batch
+	for (int32 RunStart = 0, Num = InstanceSpin.Num(); RunStart != Num;)
+	{
+		if (!InstanceSpin.IsSpinning(RunStart))
+		{
+			++RunStart;
+			continue;
+		}
+
+		int32 RunEnd = RunStart + 1;
+		while (RunEnd != Num && InstanceSpin.IsSpinning(RunEnd))
+		{
+			++RunEnd;
+		}
+
+		TransformsBuffer.Reset(RunEnd - RunStart);
+		for (int32 It = RunStart; It != RunEnd; ++It)
+		{
+			TransformsBuffer.Emplace(InstanceSpin.GetRotation(It), InstanceLocation[It], FVector(InstanceScale[It]));
+		}
+
+		// render state is marked dirty once for all runs
+		bMarkRenderStateDirty = true;
+		InstancesComp->BatchUpdateInstancesTransforms(RunStart, TransformsBuffer, true, false, true);
+
+		UpdatedNum += RunEnd - RunStart;
+		RunStart = RunEnd;
+	}
+
+	if (bMarkRenderStateDirty)
+	{
+		InstancesComp->MarkRenderStateDirty();
+	}
+
+	SET_DWORD_STAT(STAT_AsteroidFieldUpdated, UpdatedNum);
+}
+
+float AAFPS_AsteroidField::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
+{
+	const float ActualDamage = Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
+
+	// hit result item is hit instance index
+	if (DamageEvent.IsOfType(FPointDamageEvent::ClassID))
+	{
+		const FPointDamageEvent& PointDamageEvent = static_cast<const FPointDamageEvent&>(DamageEvent);
+		if (PointDamageEvent.HitInfo.Component == InstancesComp)
+		{
+			ApplyInstanceDamage(PointDamageEvent.HitInfo.Item, ActualDamage, PointDamageEvent.ShotDirection,
+				PointDamageEvent.HitInfo.ImpactPoint, EventInstigator, DamageCauser);
+		}
+	}
+
+	return ActualDamage;
+}
+
+int32 AAFPS_AsteroidField::AddAsteroid(const FTransform& SpawnTransform)
+{
+	const FQuat Rotation = SpawnTransform.GetRotation();
+	const FVector Location = SpawnTransform.GetLocation();
+	const float Scale = SpawnTransform.GetMaximumAxisScale();
+
+	int32 InstanceIndex;
+	if (FreeInstances.Num())
+	{
+		InstanceIndex = FreeInstances.Pop(false);
+
+		InstanceSpin.Set(InstanceIndex, Rotation, FVector::ZeroVector);
+		InstanceLocation[InstanceIndex] = Location;
+		InstanceScale[InstanceIndex] = Scale;
+
+		InstancesComp->UpdateInstanceTransform(InstanceIndex, FTransform(Rotation, Location, FVector(Scale)), true, true, true);
+	}
+	else
+	{
+		InstanceIndex = InstancesComp->AddInstanceWorldSpace(FTransform(Rotation, Location, FVector(Scale)));
+
+		InstanceSpin.Add(Rotation);
+		InstanceLocation.Add(Location);
+		InstanceScale.Add(Scale);
+		InstanceHealth.AddUninitialized();
+
+		SET_MEMORY_STAT(STAT_AsteroidFieldMemory, GetInstanceDataAllocatedSize());
+	}
+
+	InstanceHealth[InstanceIndex] = DefaultHealth;
+
+	++AliveInstanceNum;
+
+	if (AAFPS_GameMode* GM = GetWorld()->GetAuthGameMode<AAFPS_GameMode>())
+	{
+		GM->RegisterAsteroidFieldInstance(this, InstanceIndex);
+	}
+
+	return InstanceIndex;
+}
+
+void AAFPS_AsteroidField::ApplyInstanceDamage(int32 InstanceIndex, float Damage, const FVector& ShotDirection, const FVector& HitLocation, AController* InstigatedBy, AActor* DamageCauser)
+{
+	if (Damage <= 0.f || !IsInstanceAlive(InstanceIndex))
+	{
+		return;
+	}
+
+	// spin instance around axis perpendicular to shot and hit arm
+	const FVector HitArm = HitLocation - InstanceLocation[InstanceIndex];
+	InstanceSpin.AddAngularVelocity(InstanceIndex, FVector::CrossProduct(HitArm, ShotDirection).GetSafeNormal() * FMath::DegreesToRadians(HitSpinPerDamage * Damage));
+
+	float& Health = InstanceHealth[InstanceIndex];
+	Health = FMath::Max(Health - Damage, 0.f);
+
+	if (Health <= 0.f)
+	{
+		KillInstance(InstanceIndex);
+
+		if (AAFPS_GameMode* GM = GetWorld()->GetAuthGameMode<AAFPS_GameMode>())
+		{
+			FKillEvent KillEvent;
+			KillEvent.Victim = this;
+			KillEvent.Killer = DamageCauser;
+			KillEvent.KillerController = InstigatedBy;
+			KillEvent.Category = EKillVictimCategory::Asteroid;
+			KillEvent.InstanceIndex = InstanceIndex;
+
+			GM->GetKillEventBus().Broadcast(KillEvent);
+		}
+	}
+}
+
+void AAFPS_AsteroidField::KillInstance(int32 InstanceIndex)
+{
+	// instance is not removed to keep indices stable, zero scale hides it
+	InstanceScale[InstanceIndex] = 0.f;
+	InstanceSpin.StopSpin(InstanceIndex);
+
+	InstancesComp->UpdateInstanceTransform(InstanceIndex,
+		FTransform(InstanceSpin.GetRotation(InstanceIndex), InstanceLocation[InstanceIndex], FVector::ZeroVector), true, true, true);
+
+	FreeInstances.Add(InstanceIndex);
+	--AliveInstanceNum;
+
+	if (AAFPS_GameMode* GM = GetWorld()->GetAuthGameMode<AAFPS_GameMode>())
+	{
+		GM->UnregisterAsteroidFieldInstance(this, InstanceIndex);
+	}
+}
+
+float AAFPS_AsteroidField::GetInstanceRadius(int32 InstanceIndex) const
+{
+	const UStaticMesh* Mesh = InstancesComp->GetStaticMesh();
+	if (Mesh == nullptr)
+	{
+		return 0.f;
+	}
+
+	// mesh bounds origin may be offset from pivot
+	const FBoxSphereBounds MeshBounds = Mesh->GetBounds();
+	return (MeshBounds.Origin.Size() + MeshBounds.SphereRadius) * InstanceScale[InstanceIndex];
+}
+
+SIZE_T AAFPS_AsteroidField::GetInstanceDataAllocatedSize() const
+{
+	return InstanceHealth.GetAllocatedSize() + InstanceScale.GetAllocatedSize() + InstanceLocation.GetAllocatedSize()
+		+ InstanceSpin.GetAllocatedSize() + FreeInstances.GetAllocatedSize();
+}
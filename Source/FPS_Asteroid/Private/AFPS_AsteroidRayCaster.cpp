@@ -0,0 +1,376 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AFPS_AsteroidRayCaster.h"
+
+/** Nearest sphere entry by testing every sphere, returns hits num, negative radius spheres are skipped */
+static int32 RaycastSpheresBruteForce(const TArray<FVector>& Centers, const TArray<float>& Radii, const FVector& Origin, const FVector& Direction,
+	float MaxDistance, float& OutNearestDistance)
+{
+	int32 HitNum = 0;
+	OutNearestDistance = MAX_flt;
+	for (int32 It = 0, Num = Centers.Num(); It != Num; ++It)
+	{
+		const FVector L = Centers[It] - Origin;
+		const float Tca = L | Direction;
+		const float ThcSq = FMath::Square(Radii[It]) - (L.SizeSquared() - FMath::Square(Tca));
+		if (Radii[It] >= 0.f && ThcSq >= 0.f)
+		{
+			const float Thc = FMath::Sqrt(ThcSq);
+			const float TEnter = FMath::Max(Tca - Thc, 0.f);
+			if (Tca + Thc >= 0.f && TEnter <= MaxDistance)
+			{
+				++HitNum;
+				OutNearestDistance = FMath::Min(OutNearestDistance, TEnter);
+			}
+		}
+	}
+	return HitNum;
+}
+
+static FAutoConsoleCommand AsteroidRayCasterBenchmarkCmd(
+	TEXT("AFPS.AsteroidRayCaster.Benchmark"),
+	TEXT("Time and check ray caster against brute force sphere test at 1k, 10k and 100k spheres, before and after spheres add/remove without rebuild. Usage: AFPS.AsteroidRayCaster.Benchmark [Rays]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 RayNum = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1000;
+
+		FRandomStream Stream(1);
+		FAsteroidRayCaster RayCaster;
+		TArray<FVector> Centers;
+		TArray<float> Radii;
+		TArray<FVector> Directions;
+		TArray<FAsteroidRayHit> Hits;
+
+		for (const int32 SphereNum : { 1000, 10000, 100000 })
+		{
+			// asteroids keep ~300 uu distance, so ball volume grows with asteroids num
+			const float BallRadius = 300.f * FMath::Pow(static_cast<float>(SphereNum), 1.f / 3.f);
+			const float MaxDistance = 2.f * BallRadius;
+
+			RayCaster.Reset();
+			Centers.Reset(SphereNum);
+			Radii.Reset(SphereNum);
+			for (int32 It = 0; It != SphereNum; ++It)
+			{
+				Centers.Add(Stream.GetUnitVector() * BallRadius * FMath::Pow(Stream.GetFraction(), 1.f / 3.f));
+				Radii.Add(Stream.FRandRange(25.f, 100.f));
+				RayCaster.AddSphere(Centers.Last(), Radii.Last());
+			}
+
+			double StartTime = FPlatformTime::Seconds();
+			RayCaster.Build();
+			const double BuildMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+			Directions.Reset(RayNum);
+			for (int32 It = 0; It != RayNum; ++It)
+			{
+				Directions.Add(Stream.GetUnitVector());
+			}
+
+			// second pass checks spheres removed and added after build: every 10th removed, 1% added
+			for (const bool bChanged : { false, true })
+			{
+				if (bChanged)
+				{
+					for (int32 It = 0; It < SphereNum; It += 10)
+					{
+						RayCaster.RemoveSphere(It);
+						Radii[It] = -1.f;
+					}
+					for (int32 It = 0, AddNum = SphereNum / 100; It != AddNum; ++It)
+					{
+						Centers.Add(Stream.GetUnitVector() * BallRadius * FMath::Pow(Stream.GetFraction(), 1.f / 3.f));
+						Radii.Add(Stream.FRandRange(25.f, 100.f));
+						RayCaster.AddSphere(Centers.Last(), Radii.Last());
+					}
+				}
+
+				int32 BruteForceHitNum = 0;
+				TArray<float> NearestDistances;
+				NearestDistances.SetNumUninitialized(RayNum);
+				StartTime = FPlatformTime::Seconds();
+				for (int32 It = 0; It != RayNum; ++It)
+				{
+					BruteForceHitNum += RaycastSpheresBruteForce(Centers, Radii, FVector::ZeroVector, Directions[It], MaxDistance, NearestDistances[It]);
+				}
+				const double BruteForceMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+				int32 RayCasterHitNum = 0;
+				int32 MismatchNum = 0;
+				StartTime = FPlatformTime::Seconds();
+				for (int32 It = 0; It != RayNum; ++It)
+				{
+					RayCasterHitNum += RayCaster.Raycast(FVector::ZeroVector, Directions[It], MaxDistance, Hits);
+
+					// vector reciprocal sqrt is not exact, nearest entry is compared with tolerance
+					const float NearestDistance = Hits.Num() ? Hits[0].Distance : MAX_flt;
+					MismatchNum += !FMath::IsNearlyEqual(NearestDistance, NearestDistances[It], 1.f);
+				}
+				const double RayCasterMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+				UE_LOG(LogTemp, Display, TEXT("[AsteroidRayCaster] %d spheres%s, %d rays: build %.3f ms, brute force %.3f ms, ray caster %.3f ms (x%.1f), hits %d/%d, nearest mismatches %d%s"),
+					SphereNum, bChanged ? TEXT(" (10% removed, 1% added)") : TEXT(""), RayNum, BuildMs, BruteForceMs, RayCasterMs,
+					RayCasterMs > 0.0 ? BruteForceMs / RayCasterMs : 0.0, RayCasterHitNum, BruteForceHitNum, MismatchNum,
+					MismatchNum || RayCasterHitNum != BruteForceHitNum ? TEXT(" MISMATCH") : TEXT(""));
+			}
+		}
+	})
+);
+
+void FAsteroidRayCaster::Reset()
+{
+	Centers.Reset();
+	Radii.Reset();
+	SphereSlots.Reset();
+	Nodes.Reset();
+	SlotX.Reset();
+	SlotY.Reset();
+	SlotZ.Reset();
+	SlotRadiusSq.Reset();
+	SlotSphere.Reset();
+	IndexedNum = 0;
+	RemovedNum = 0;
+}
+
+int32 FAsteroidRayCaster::AddSphere(const FVector& Center, float Radius)
+{
+	Radii.Add(FMath::Max(Radius, 0.f));
+	SphereSlots.Add(INDEX_NONE);
+	return Centers.Add(Center);
+}
+
+void FAsteroidRayCaster::RemoveSphere(int32 SphereIndex)
+{
+	if (!Radii.IsValidIndex(SphereIndex) || Radii[SphereIndex] < 0.f)
+	{
+		return;
+	}
+
+	Radii[SphereIndex] = -1.f;
+	++RemovedNum;
+
+	// slot is skipped by raycast same as leaf padding
+	if (SphereSlots[SphereIndex] != INDEX_NONE)
+	{
+		SlotRadiusSq[SphereSlots[SphereIndex]] = -1.f;
+		SphereSlots[SphereIndex] = INDEX_NONE;
+	}
+}
+
+void FAsteroidRayCaster::Build()
+{
+	Nodes.Reset();
+	SlotX.Reset();
+	SlotY.Reset();
+	SlotZ.Reset();
+	SlotRadiusSq.Reset();
+	SlotSphere.Reset();
+
+	BuildOrder.Reset(Centers.Num());
+	for (int32 It = 0, End = Centers.Num(); It != End; ++It)
+	{
+		SphereSlots[It] = INDEX_NONE;
+		if (Radii[It] >= 0.f)
+		{
+			BuildOrder.Add(It);
+		}
+	}
+
+	const int32 SphereNum = BuildOrder.Num();
+	if (SphereNum)
+	{
+		// binary tree with LeafSize spheres leaves
+		Nodes.Reserve(2 * FMath::DivideAndRoundUp(SphereNum, LeafSize));
+		Nodes.AddUninitialized();
+		BuildNode(0, 0, SphereNum);
+	}
+
+	IndexedNum = Centers.Num();
+}
+
+void FAsteroidRayCaster::BuildNode(int32 NodeIndex, int32 First, int32 Count)
+{
+	FVector Min(BIG_NUMBER);
+	FVector Max(-BIG_NUMBER);
+	FVector CenterMin(BIG_NUMBER);
+	FVector CenterMax(-BIG_NUMBER);
+	for (int32 It = First, End = First + Count; It != End; ++It)
+	{
+		const FVector& Center = Centers[BuildOrder[It]];
+		const FVector Extent(Radii[BuildOrder[It]]);
+		Min = Min.ComponentMin(Center - Extent);
+		Max = Max.ComponentMax(Center + Extent);
+		CenterMin = CenterMin.ComponentMin(Center);
+		CenterMax = CenterMax.ComponentMax(Center);
+	}
+
+	Nodes[NodeIndex].Min = Min;
+	Nodes[NodeIndex].Max = Max;
+
+	if (Count <= LeafSize)
+	{
+		// leaf spheres are stored in own slots, padded to LeafSize
+		const int32 FirstSlot = SlotSphere.Num();
+		for (int32 It = 0; It != LeafSize; ++It)
+		{
+			const bool bUsed = It < Count;
+			const int32 SphereIndex = bUsed ? BuildOrder[First + It] : INDEX_NONE;
+			const FVector Center = bUsed ? Centers[SphereIndex] : FVector::ZeroVector;
+
+			SlotX.Add(Center.X);
+			SlotY.Add(Center.Y);
+			SlotZ.Add(Center.Z);
+			SlotRadiusSq.Add(bUsed ? FMath::Square(Radii[SphereIndex]) : -1.f);
+			SlotSphere.Add(SphereIndex);
+
+			if (bUsed)
+			{
+				SphereSlots[SphereIndex] = FirstSlot + It;
+			}
+		}
+
+		Nodes[NodeIndex].ChildOrFirst = FirstSlot;
+		Nodes[NodeIndex].bLeaf = true;
+		return;
+	}
+
+	// median split by longest centers axis
+	const FVector CenterExtent = CenterMax - CenterMin;
+	const int32 Axis = CenterExtent.X >= CenterExtent.Y ? (CenterExtent.X >= CenterExtent.Z ? 0 : 2) : (CenterExtent.Y >= CenterExtent.Z ? 1 : 2);
+
+	Sort(BuildOrder.GetData() + First, Count, [this, Axis](int32 A, int32 B) { return Centers[A][Axis] < Centers[B][Axis]; });
+
+	const int32 LeftCount = Count / 2;
+
+	const int32 ChildIndex = Nodes.AddUninitialized(2);
+	Nodes[NodeIndex].ChildOrFirst = ChildIndex;
+	Nodes[NodeIndex].bLeaf = false;
+
+	BuildNode(ChildIndex, First, LeftCount);
+	BuildNode(ChildIndex + 1, First + LeftCount, Count - LeftCount);
+}
+
+int32 FAsteroidRayCaster::Raycast(const FVector& Origin, const FVector& Direction, float MaxDistance, TArray<FAsteroidRayHit>& OutHits) const
+{
+	OutHits.Reset();
+
+	// spheres added after build, usually few
+	for (int32 SphereIndex = IndexedNum, SphereNum = Centers.Num(); SphereIndex < SphereNum; ++SphereIndex)
+	{
+		const float Radius = Radii[SphereIndex];
+		const FVector L = Centers[SphereIndex] - Origin;
+		const float Tca = L | Direction;
+		const float ThcSq = FMath::Square(Radius) - (L.SizeSquared() - FMath::Square(Tca));
+		if (Radius >= 0.f && ThcSq >= 0.f)
+		{
+			const float Thc = FMath::Sqrt(ThcSq);
+			const float TEnter = FMath::Max(Tca - Thc, 0.f);
+			if (Tca + Thc >= 0.f && TEnter <= MaxDistance)
+			{
+				OutHits.Add({ SphereIndex, TEnter });
+			}
+		}
+	}
+
+	if (Nodes.Num() == 0)
+	{
+		OutHits.Sort([](const FAsteroidRayHit& A, const FAsteroidRayHit& B) { return A.Distance < B.Distance; });
+		return OutHits.Num();
+	}
+
+	// slab test data
+	const FVector InvDirection(
+		FMath::Abs(Direction.X) > SMALL_NUMBER ? 1.f / Direction.X : BIG_NUMBER,
+		FMath::Abs(Direction.Y) > SMALL_NUMBER ? 1.f / Direction.Y : BIG_NUMBER,
+		FMath::Abs(Direction.Z) > SMALL_NUMBER ? 1.f / Direction.Z : BIG_NUMBER);
+
+	auto RayHitsNode = [&](const FNode& Node)
+	{
+		const FVector T0 = (Node.Min - Origin) * InvDirection;
+		const FVector T1 = (Node.Max - Origin) * InvDirection;
+		const float TNear = FMath::Max(T0.ComponentMin(T1).GetMax(), 0.f);
+		const float TFar = FMath::Min(T0.ComponentMax(T1).GetMin(), MaxDistance);
+		return TNear <= TFar;
+	};
+
+	const VectorRegister OriginX = VectorSetFloat1(Origin.X);
+	const VectorRegister OriginY = VectorSetFloat1(Origin.Y);
+	const VectorRegister OriginZ = VectorSetFloat1(Origin.Z);
+	const VectorRegister DirectionX = VectorSetFloat1(Direction.X);
+	const VectorRegister DirectionY = VectorSetFloat1(Direction.Y);
+	const VectorRegister DirectionZ = VectorSetFloat1(Direction.Z);
+	const VectorRegister MaxT = VectorSetFloat1(MaxDistance);
+	const VectorRegister SmallNumber = VectorSetFloat1(SMALL_NUMBER);
+
+	int32 Stack[64];
+	int32 StackNum = 0;
+	Stack[StackNum++] = 0;
+
+	while (StackNum)
+	{
+		const FNode& Node = Nodes[Stack[--StackNum]];
+		if (!RayHitsNode(Node))
+		{
+			continue;
+		}
+
+		if (!Node.bLeaf)
+		{
+			// tree depth is log2 of leaves num, stack can't overflow for any real spheres num
+			checkSlow(StackNum + 2 <= UE_ARRAY_COUNT(Stack));
+			Stack[StackNum++] = Node.ChildOrFirst + 1;
+			Stack[StackNum++] = Node.ChildOrFirst;
+			continue;
+		}
+
+		const int32 Slot = Node.ChildOrFirst;
+
+		// L = C - O, Tca = L.D, D2 = L.L - Tca^2, Thc = sqrt(R^2 - D2), hit range [Tca - Thc, Tca + Thc]
+		const VectorRegister LX = VectorSubtract(VectorLoad(SlotX.GetData() + Slot), OriginX);
+		const VectorRegister LY = VectorSubtract(VectorLoad(SlotY.GetData() + Slot), OriginY);
+		const VectorRegister LZ = VectorSubtract(VectorLoad(SlotZ.GetData() + Slot), OriginZ);
+		const VectorRegister RadiusSq = VectorLoad(SlotRadiusSq.GetData() + Slot);
+
+		const VectorRegister Tca = VectorMultiplyAdd(LZ, DirectionZ, VectorMultiplyAdd(LY, DirectionY, VectorMultiply(LX, DirectionX)));
+		const VectorRegister LengthSq = VectorMultiplyAdd(LZ, LZ, VectorMultiplyAdd(LY, LY, VectorMultiply(LX, LX)));
+		const VectorRegister ThcSq = VectorSubtract(RadiusSq, VectorSubtract(LengthSq, VectorMultiply(Tca, Tca)));
+
+		// sqrt(x) = x * 1/sqrt(x), clamped to avoid division by zero
+		const VectorRegister ThcSqClamped = VectorMax(ThcSq, SmallNumber);
+		const VectorRegister Thc = VectorMultiply(ThcSqClamped, VectorReciprocalSqrtAccurate(ThcSqClamped));
+
+		const VectorRegister TEnter = VectorMax(VectorSubtract(Tca, Thc), GlobalVectorConstants::FloatZero);
+		const VectorRegister TExit = VectorAdd(Tca, Thc);
+
+		VectorRegister HitMask = VectorCompareGE(ThcSq, GlobalVectorConstants::FloatZero);
+		HitMask = VectorBitwiseAnd(HitMask, VectorCompareGE(RadiusSq, GlobalVectorConstants::FloatZero));
+		HitMask = VectorBitwiseAnd(HitMask, VectorCompareGE(TExit, GlobalVectorConstants::FloatZero));
+		HitMask = VectorBitwiseAnd(HitMask, VectorCompareGE(MaxT, TEnter));
+
+		const int32 HitBits = VectorMaskBits(HitMask);
+		if (HitBits)
+		{
+			float Distances[LeafSize];
+			VectorStore(TEnter, Distances);
+
+			for (int32 It = 0; It != LeafSize; ++It)
+			{
+				if (HitBits & (1 << It))
+				{
+					OutHits.Add({ SlotSphere[Slot + It], Distances[It] });
+				}
+			}
+		}
+	}
+
+	OutHits.Sort([](const FAsteroidRayHit& A, const FAsteroidRayHit& B) { return A.Distance < B.Distance; });
+
+	return OutHits.Num();
+}
+
+SIZE_T FAsteroidRayCaster::GetAllocatedSize() const
+{
+	return Centers.GetAllocatedSize() + Radii.GetAllocatedSize() + SphereSlots.GetAllocatedSize() + BuildOrder.GetAllocatedSize() + Nodes.GetAllocatedSize()
+		+ SlotX.GetAllocatedSize() + SlotY.GetAllocatedSize() + SlotZ.GetAllocatedSize() + SlotRadiusSq.GetAllocatedSize() + SlotSphere.GetAllocatedSize();
+}
@@ -0,0 +1,180 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AFPS_AsteroidSpawnGrid.h"
+
+static FAutoConsoleCommand SpawnGridBenchmarkCmd(
+	TEXT("AFPS.AsteroidSpawner.BenchmarkSpawnGrid"),
+	TEXT("Time spawn point rejection test of spawn grid against linear scan at 100, 1k and 10k asteroids. Usage: AFPS.AsteroidSpawner.BenchmarkSpawnGrid [Queries] [MinDistance]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 QueryNum = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 20000;
+		const float MinDistance = Args.Num() > 1 ? FMath::Max(FCString::Atof(*Args[1]), 1.f) : 1000.f;
+
+		FRandomStream Stream(1);
+		FAsteroidSpawnGrid Grid;
+		TArray<FVector> Points;
+		TArray<FVector> Queries;
+
+		for (const int32 AsteroidNum : { 100, 1000, 10000 })
+		{
+			// asteroids on spawn sphere shell (wave radius grows with asteroids num), queries around it
+			const float Radius = MinDistance * FMath::Sqrt(static_cast<float>(AsteroidNum));
+
+			Grid.Reset(MinDistance);
+			Points.Reset(AsteroidNum);
+			for (int32 It = 0; It != AsteroidNum; ++It)
+			{
+				Points.Add(Stream.GetUnitVector() * Radius);
+				Grid.Add(Points.Last());
+			}
+
+			Queries.Reset(QueryNum);
+			for (int32 It = 0; It != QueryNum; ++It)
+			{
+				Queries.Add(Stream.GetUnitVector() * Radius);
+			}
+
+			// linear scan, same as spawner did before the grid
+			int32 LinearFreeNum = 0;
+			double StartTime = FPlatformTime::Seconds();
+			for (const FVector& Query : Queries)
+			{
+				bool bFree = true;
+				for (const FVector& Point : Points)
+				{
+					if (FVector::DistSquared(Query, Point) < FMath::Square(MinDistance))
+					{
+						bFree = false;
+						break;
+					}
+				}
+				LinearFreeNum += bFree;
+			}
+			const double LinearMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+			int32 GridFreeNum = 0;
+			StartTime = FPlatformTime::Seconds();
+			for (const FVector& Query : Queries)
+			{
+				GridFreeNum += Grid.IsPointFree(Query, MinDistance);
+			}
+			const double GridMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+			UE_LOG(LogTemp, Display, TEXT("[SpawnGrid] %d asteroids, %d queries: linear %.3f ms, grid %.3f ms (x%.1f), free %d/%d%s"),
+				AsteroidNum, QueryNum, LinearMs, GridMs, GridMs > 0.0 ? LinearMs / GridMs : 0.0, GridFreeNum, LinearFreeNum,
+				GridFreeNum == LinearFreeNum ? TEXT("") : TEXT(" MISMATCH"));
+		}
+	})
+);
+
+void FAsteroidSpawnGrid::Reset(float InCellSize)
+{
+	Cells.Reset();
+	PointNum = 0;
+
+	CellSize = FMath::Max(InCellSize, KINDA_SMALL_NUMBER);
+	InvCellSize = 1.f / CellSize;
+}
+
+void FAsteroidSpawnGrid::Add(const FVector& Point)
+{
+	Cells.FindOrAdd(GetCell(Point)).Add(Point);
+	++PointNum;
+}
+
+bool FAsteroidSpawnGrid::Remove(const FVector& InPoint)
+{
+	// asteroids are translation locked, but physics can still move them a bit, so search closest point around
+	const FIntVector Center = GetCell(InPoint);
+
+	TArray<FVector>* ClosestCell = nullptr;
+	FIntVector ClosestCellKey;
+	int32 ClosestIndex = INDEX_NONE;
+	float ClosestSquareDist = MAX_flt;
+
+	for (int32 X = -1; X <= 1; ++X)
+	{
+		for (int32 Y = -1; Y <= 1; ++Y)
+		{
+			for (int32 Z = -1; Z <= 1; ++Z)
+			{
+				const FIntVector Key = Center + FIntVector(X, Y, Z);
+				TArray<FVector>* Points = Cells.Find(Key);
+				if (Points == nullptr)
+				{
+					continue;
+				}
+
+				for (int32 It = 0, Num = Points->Num(); It != Num; ++It)
+				{
+					const float SquareDist = FVector::DistSquared(InPoint, (*Points)[It]);
+					if (SquareDist < ClosestSquareDist)
+					{
+						ClosestSquareDist = SquareDist;
+						ClosestCell = Points;
+						ClosestCellKey = Key;
+						ClosestIndex = It;
+					}
+				}
+			}
+		}
+	}
+
+	if (ClosestCell == nullptr)
+	{
+		return false;
+	}
+
+	ClosestCell->RemoveAtSwap(ClosestIndex, 1, false);
+	if (ClosestCell->Num() == 0)
+	{
+		Cells.Remove(ClosestCellKey);
+	}
+	--PointNum;
+
+	return true;
+}
+
+bool FAsteroidSpawnGrid::IsPointFree(const FVector& InPoint, float MinDistance) const
+{
+	const float SquareDistTreshold = FMath::Square(MinDistance);
+	const FIntVector Center = GetCell(InPoint);
+
+	for (int32 X = -1; X <= 1; ++X)
+	{
+		for (int32 Y = -1; Y <= 1; ++Y)
+		{
+			for (int32 Z = -1; Z <= 1; ++Z)
+			{
+				const TArray<FVector>* Points = Cells.Find(Center + FIntVector(X, Y, Z));
+				if (Points == nullptr)
+				{
+					continue;
+				}
+
+				for (const FVector& Point : *Points)
+				{
+					if (FVector::DistSquared(InPoint, Point) < SquareDistTreshold)
+					{
+						// found point that is closer then MinDistance
+						return false;
+					}
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+SIZE_T FAsteroidSpawnGrid::GetAllocatedSize() const
+{
+	SIZE_T Size = Cells.GetAllocatedSize();
+	for (const TPair<FIntVector, TArray<FVector>>& Cell : Cells)
+	{
+		Size += Cell.Value.GetAllocatedSize();
+	}
+
+	return Size;
+}
@@ -0,0 +1,319 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AFPS_AsteroidSpawnSampler.h"
+
+#include "AFPS_AsteroidSpawnGrid.h"
+
+/** Chi-square of unit directions over ZBands * Sectors equal area sphere bins, around ZBands * Sectors - 1 for uniform directions */
+static float CalcSphereBinsChiSquare(TArrayView<const FVector> Directions, int32 ZBands, int32 Sectors)
+{
+	TArray<int32> Bins;
+	Bins.SetNumZeroed(ZBands * Sectors);
+
+	// equal Z bands have equal area on sphere (Archimedes)
+	for (const FVector& Direction : Directions)
+	{
+		const int32 Band = FMath::Clamp(FMath::FloorToInt((Direction.Z + 1.f) * 0.5f * ZBands), 0, ZBands - 1);
+		const float Azimuth = FMath::Atan2(Direction.Y, Direction.X) + PI;
+		const int32 Sector = FMath::Clamp(FMath::FloorToInt(Azimuth / (2.f * PI) * Sectors), 0, Sectors - 1);
+		++Bins[Band * Sectors + Sector];
+	}
+
+	const float Expected = static_cast<float>(Directions.Num()) / Bins.Num();
+	float ChiSquare = 0.f;
+	for (const int32 Count : Bins)
+	{
+		ChiSquare += FMath::Square(Count - Expected) / Expected;
+	}
+
+	return ChiSquare;
+}
+
+/** p = 0.001 chi-square critical value for DegreesOfFreedom, Wilson-Hilferty approximation */
+static float CalcChiSquareCritical(int32 DegreesOfFreedom)
+{
+	const float K = static_cast<float>(FMath::Max(DegreesOfFreedom, 1));
+	const float Variance = 2.f / (9.f * K);
+	return K * FMath::Cube(1.f - Variance + 3.09f * FMath::Sqrt(Variance));
+}
+
+static FAutoConsoleCommand PoissonDiskSphereTestCmd(
+	TEXT("AFPS.AsteroidSpawner.TestPoissonDiskSphere"),
+	TEXT("Check poisson disk sphere sampler separation, determinism and coverage, and time it at 10, 100 and 1k points. Usage: AFPS.AsteroidSpawner.TestPoissonDiskSphere [Iterations]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 Iterations = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 20;
+
+		// spawner defaults: 3 m between asteroids, 1 km max wave radius
+		const float Radius = 1'000'00.f;
+		const float MinDistance = 3'00.f;
+		const int32 CandidatesNum = 20;
+
+		TArray<FVector> Points, ReplayPoints, Directions;
+
+		for (const int32 PointNum : { 10, 100, 1000 })
+		{
+			FRandomStream Stream(PointNum);
+			FAsteroidSpawnSampler::PoissonDiskSphere(FVector::ZeroVector, Radius, MinDistance, PointNum, CandidatesNum, Stream,
+				[](const FVector&) { return true; }, Points);
+
+			Stream.Initialize(PointNum);
+			FAsteroidSpawnSampler::PoissonDiskSphere(FVector::ZeroVector, Radius, MinDistance, PointNum, CandidatesNum, Stream,
+				[](const FVector&) { return true; }, ReplayPoints);
+
+			const bool bDeterministic = Points == ReplayPoints;
+
+			float MinPairDistance = MAX_flt;
+			for (int32 A = 0; A != Points.Num(); ++A)
+			{
+				for (int32 B = A + 1; B != Points.Num(); ++B)
+				{
+					MinPairDistance = FMath::Min(MinPairDistance, FVector::Dist(Points[A], Points[B]));
+				}
+			}
+
+			// single patch around first seed has mean direction length close to 1, sphere coverage close to 0
+			Directions.Reset(Points.Num());
+			FVector MeanDirection = FVector::ZeroVector;
+			for (const FVector& Point : Points)
+			{
+				Directions.Add(Point.GetSafeNormal());
+				MeanDirection += Directions.Last() / Points.Num();
+			}
+
+			// ~4 points expected per bin
+			const int32 Sectors = FMath::Clamp(Points.Num() / 8, 1, 16);
+			const float ChiSquare = CalcSphereBinsChiSquare(Directions, 2, Sectors);
+			const float ChiSquareCritical = CalcChiSquareCritical(2 * Sectors - 1);
+
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 It = 0; It != Iterations; ++It)
+			{
+				FAsteroidSpawnSampler::PoissonDiskSphere(FVector::ZeroVector, Radius, MinDistance, PointNum, CandidatesNum, Stream,
+					[](const FVector&) { return true; }, ReplayPoints);
+			}
+			const double AvgMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / Iterations;
+
+			const bool bPassed = Points.Num() == PointNum && bDeterministic && MinPairDistance >= MinDistance * 0.999f
+				&& MeanDirection.Size() < 0.5f && ChiSquare < ChiSquareCritical;
+
+			UE_LOG(LogTemp, Display, TEXT("[PoissonDiskSphere] %s %d/%d points: min distance %.1f, deterministic %s, mean direction %.3f, chi-square %.1f (critical %.1f), %.4f ms per wave"),
+				bPassed ? TEXT("PASSED") : TEXT("FAILED"), Points.Num(), PointNum, MinPairDistance, bDeterministic ? TEXT("true") : TEXT("false"),
+				MeanDirection.Size(), ChiSquare, ChiSquareCritical, AvgMs);
+		}
+	})
+);
+
+static FAutoConsoleCommand UniformSpherePointsTestCmd(
+	TEXT("AFPS.AsteroidSpawner.TestUniformSpherePoints"),
+	TEXT("Check batched sphere points uniformity and time them against old per point pitch/yaw path. Usage: AFPS.AsteroidSpawner.TestUniformSpherePoints [Points] [Iterations]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 PointNum = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 128) : 100000;
+		const int32 Iterations = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 10;
+
+		// 8 equal area Z bands * 16 sectors
+		const int32 ZBands = 8;
+		const int32 Sectors = 16;
+		const float ChiSquareCritical = CalcChiSquareCritical(ZBands * Sectors - 1);
+
+		FRandomStream Stream(1);
+		FSpherePointsSoA Points;
+		TArray<FVector> Directions;
+		Directions.Reserve(PointNum);
+
+		// batched
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 It = 0; It != Iterations; ++It)
+		{
+			FAsteroidSpawnSampler::UniformSpherePoints(PointNum, Stream, Points);
+		}
+		const double BatchedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / Iterations;
+
+		FVector MeanDirection = FVector::ZeroVector;
+		float MaxLengthError = 0.f;
+		for (int32 It = 0; It != PointNum; ++It)
+		{
+			Directions.Add(Points.GetPoint(It));
+			MeanDirection += Directions.Last() / PointNum;
+			MaxLengthError = FMath::Max(MaxLengthError, FMath::Abs(Directions.Last().Size() - 1.f));
+		}
+		const float BatchedChiSquare = CalcSphereBinsChiSquare(Directions, ZBands, Sectors);
+		const bool bPassed = BatchedChiSquare < ChiSquareCritical && MeanDirection.Size() < 0.01f && MaxLengthError < 1.e-3f;
+
+		// old CalcAsteroidSpawnPointOffset path, uniform pitch and yaw in [-2pi, 2pi]
+		StartTime = FPlatformTime::Seconds();
+		for (int32 It = 0; It != Iterations; ++It)
+		{
+			Directions.Reset();
+			for (int32 PointIt = 0; PointIt != PointNum; ++PointIt)
+			{
+				const float SpherePitch = Stream.FRandRange(-PI * 2.f, PI * 2.f);
+				const float SphereYaw = Stream.FRandRange(-PI * 2.f, PI * 2.f);
+				Directions.Add(FVector(cosf(SphereYaw) * sinf(SpherePitch), sinf(SphereYaw) * sinf(SpherePitch), cosf(SpherePitch)));
+			}
+		}
+		const double PerPointMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / Iterations;
+		const float PerPointChiSquare = CalcSphereBinsChiSquare(Directions, ZBands, Sectors);
+
+		UE_LOG(LogTemp, Display, TEXT("[UniformSpherePoints] %s %d points: batched chi-square %.1f (critical %.1f), mean direction %.4f, max length error %g, %.3f ms"),
+			bPassed ? TEXT("PASSED") : TEXT("FAILED"), PointNum, BatchedChiSquare, ChiSquareCritical, MeanDirection.Size(), MaxLengthError, BatchedMs);
+		UE_LOG(LogTemp, Display, TEXT("[UniformSpherePoints] per point pitch/yaw: chi-square %.1f, %.3f ms (batched x%.1f)"),
+			PerPointChiSquare, PerPointMs, BatchedMs > 0.0 ? PerPointMs / BatchedMs : 0.0);
+	})
+);
+
+void FAsteroidSpawnSampler::UniformSpherePoints(int32 NumPoints, FRandomStream& Stream, FSpherePointsSoA& OutPoints)
+{
+	NumPoints = FMath::Max(NumPoints, 0);
+	OutPoints.SetNumUninitialized(NumPoints);
+
+	float* RESTRICT X = OutPoints.X.GetData();
+	float* RESTRICT Y = OutPoints.Y.GetData();
+	float* RESTRICT Z = OutPoints.Z.GetData();
+
+	// random Z and azimuth, azimuth is stored in Y until sphere point calculation
+	for (int32 It = 0; It != NumPoints; ++It)
+	{
+		Z[It] = Stream.FRandRange(-1.f, 1.f);
+		Y[It] = Stream.FRandRange(-PI, PI);
+	}
+
+	// x = sqrt(1 - z^2) * cos(azimuth), y = sqrt(1 - z^2) * sin(azimuth)
+	const int32 VectorNum = NumPoints & ~3;
+	const VectorRegister SmallNumber = VectorSetFloat1(SMALL_NUMBER);
+
+	int32 It = 0;
+	for (; It != VectorNum; It += 4)
+	{
+		const VectorRegister VZ = VectorLoad(Z + It);
+		const VectorRegister VAzimuth = VectorLoad(Y + It);
+
+		// sqrt(r2) = r2 * 1/sqrt(r2), clamped to avoid division by zero on poles
+		const VectorRegister VR2 = VectorMax(VectorSubtract(GlobalVectorConstants::FloatOne, VectorMultiply(VZ, VZ)), GlobalVectorConstants::FloatZero);
+		const VectorRegister VR = VectorMultiply(VR2, VectorReciprocalSqrtAccurate(VectorMax(VR2, SmallNumber)));
+
+		VectorRegister VSin, VCos;
+		VectorSinCos(&VSin, &VCos, &VAzimuth);
+
+		VectorStore(VectorMultiply(VR, VCos), X + It);
+		VectorStore(VectorMultiply(VR, VSin), Y + It);
+	}
+
+	// tail
+	for (; It != NumPoints; ++It)
+	{
+		const float R = FMath::Sqrt(FMath::Max(1.f - Z[It] * Z[It], 0.f));
+
+		float SinAzimuth, CosAzimuth;
+		FMath::SinCos(&SinAzimuth, &CosAzimuth, Y[It]);
+
+		X[It] = R * CosAzimuth;
+		Y[It] = R * SinAzimuth;
+	}
+}
+
+int32 FAsteroidSpawnSampler::PoissonDiskSphere(const FVector& Origin, float Radius, float MinDistance, int32 NumPoints, int32 CandidatesNum,
+	FRandomStream& Stream, TFunctionRef<bool(const FVector&)> IsPointAllowed, TArray<FVector>& OutPoints)
+{
+	OutPoints.Reset(FMath::Max(NumPoints, 0));
+
+	if (NumPoints <= 0 || Radius <= 0.f)
+	{
+		return 0;
+	}
+
+	CandidatesNum = FMath::Max(CandidatesNum, 1);
+
+	// sampled points of this batch
+	FAsteroidSpawnGrid BatchGrid;
+	BatchGrid.Reset(MinDistance);
+
+	// indices of OutPoints which can still spawn candidates around
+	TArray<int32> ActivePoints;
+	ActivePoints.Reserve(NumPoints);
+
+	auto TryAcceptPoint = [&](const FVector& Point)
+	{
+		if (BatchGrid.IsPointFree(Point, MinDistance) && IsPointAllowed(Point))
+		{
+			ActivePoints.Add(OutPoints.Add(Point));
+			BatchGrid.Add(Point);
+			return true;
+		}
+		return false;
+	};
+
+	// candidate arc distance is converted to angle around sphere center
+	const float InvRadius = 1.f / Radius;
+
+	// seed points are uniform sphere points, generated by batches
+	FSpherePointsSoA SeedPoints;
+	int32 SeedPointIndex = 0;
+
+	int32 SeedAttempts = 0;
+
+	while (OutPoints.Num() < NumPoints)
+	{
+		// uniform seed is tried before every growth step, so sparse waves are spread over whole sphere
+		// and active points only fill space between seeds once sphere gets dense
+		if (SeedAttempts < CandidatesNum)
+		{
+			if (SeedPointIndex == SeedPoints.Num())
+			{
+				UniformSpherePoints(CandidatesNum, Stream, SeedPoints);
+				SeedPointIndex = 0;
+			}
+
+			if (TryAcceptPoint(Origin + SeedPoints.GetPoint(SeedPointIndex++) * Radius))
+			{
+				SeedAttempts = 0;
+				continue;
+			}
+			++SeedAttempts;
+		}
+
+		if (ActivePoints.Num() == 0)
+		{
+			if (SeedAttempts == CandidatesNum)
+			{
+				break;  // no free space found by seeds and nothing to grow from
+			}
+			continue;
+		}
+
+		const int32 ActiveIndex = Stream.RandHelper(ActivePoints.Num());
+		const FVector Normal = (OutPoints[ActivePoints[ActiveIndex]] - Origin) * InvRadius;
+
+		FVector TangentX, TangentY;
+		Normal.FindBestAxisVectors(TangentX, TangentY);
+
+		bool bCandidateAccepted = false;
+		for (int32 Candidate = 0; Candidate != CandidatesNum; ++Candidate)
+		{
+			const float ArcAngle = Stream.FRandRange(MinDistance, 2.f * MinDistance) * InvRadius;
+			const float TangentAngle = Stream.FRandRange(0.f, 2.f * PI);
+
+			float SinArc, CosArc, SinTangent, CosTangent;
+			FMath::SinCos(&SinArc, &CosArc, ArcAngle);
+			FMath::SinCos(&SinTangent, &CosTangent, TangentAngle);
+
+			const FVector Direction = TangentX * CosTangent + TangentY * SinTangent;
+			const FVector CandidatePoint = Origin + (Normal * CosArc + Direction * SinArc) * Radius;
+
+			if (TryAcceptPoint(CandidatePoint))
+			{
+				bCandidateAccepted = true;
+				break;
+			}
+		}
+
+		if (!bCandidateAccepted)
+		{
+			ActivePoints.RemoveAtSwap(ActiveIndex, 1, false);
+		}
+	}
+
+	return OutPoints.Num();
+}
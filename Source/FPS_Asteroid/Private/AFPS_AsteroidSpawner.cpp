@@ -4,14 +4,28 @@
 #include "AFPS_AsteroidSpawner.h"
 
 #include "AFPS_Asteroid.h"
+#include "AFPS_AsteroidField.h"
 #include "AFPS_GameMode.h"
-
-#include "Kismet/GameplayStatics.h"
+#include "AFPS_HUD.h"
+#include "AFPS_AsteroidSpawnSampler.h"
+#include "AFPS_ScopeStats.h"
+#include "Components/AFPS_AsteroidPoolComponent.h"
+#include "Components/AFPS_AsteroidSignificanceComponent.h"
 
 #include <FPS_Asteroid/FPS_Asteroid.h>
 
 #include "DrawDebugHelpers.h"
 
+DECLARE_CYCLE_STAT(TEXT("Spawn Queue Process"), STAT_AsteroidSpawnQueue, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spawn Queue Depth"), STAT_AsteroidSpawnQueueDepth, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spawned Per Frame"), STAT_AsteroidSpawnedPerFrame, STATGROUP_FPSAsteroid);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Spawn Latency Max (ms)"), STAT_AsteroidSpawnLatency, STATGROUP_FPSAsteroid);
+DECLARE_MEMORY_STAT(TEXT("Spawn Queue"), STAT_AsteroidSpawnQueueMemory, STATGROUP_FPSAsteroid);
+DECLARE_MEMORY_STAT(TEXT("Spawn Grid"), STAT_AsteroidSpawnGridMemory, STATGROUP_FPSAsteroid);
+
+AFPS_DECLARE_SCOPE_STAT("Spawner Start Wave", SpawnerStartWave);
+AFPS_DECLARE_SCOPE_STAT("Spawner Calc Spawn Transform", SpawnerCalcSpawnTransform);
+AFPS_DECLARE_SCOPE_STAT("Spawner Spawn Point Valid", SpawnerSpawnPointValid);
 
 TAutoConsoleVariable<bool> CVarDrawDebugAsteroidSpawner(
 	TEXT("AFPS.DrawDebug.AsteroidSpawner"),
@@ -20,14 +34,100 @@ TAutoConsoleVariable<bool> CVarDrawDebugAsteroidSpawner(
 	ECVF_Cheat
 );
 
+/** Checksum of transforms bits, equal on every run for same seed, wave and spawn params */
+static uint32 CalcSpawnTransformsChecksum(const TArray<FTransform>& SpawnTransforms)
+{
+	uint32 Checksum = 0;
+	for (const FTransform& SpawnTransform : SpawnTransforms)
+	{
+		const FVector Location = SpawnTransform.GetLocation();
+		const FQuat Rotation = SpawnTransform.GetRotation();
+		const FVector Scale = SpawnTransform.GetScale3D();
+		Checksum = FCrc::MemCrc32(&Location, sizeof(Location), Checksum);
+		Checksum = FCrc::MemCrc32(&Rotation, sizeof(Rotation), Checksum);
+		Checksum = FCrc::MemCrc32(&Scale, sizeof(Scale), Checksum);
+	}
+	return Checksum;
+}
+
+/** Compare transforms bit by bit, per component since not vectorized FTransform has padding */
+static bool AreSpawnTransformsEqual(const TArray<FTransform>& A, const TArray<FTransform>& B)
+{
+	if (A.Num() != B.Num())
+	{
+		return false;
+	}
+
+	for (int32 It = 0; It != A.Num(); ++It)
+	{
+		const FVector LocationA = A[It].GetLocation(), LocationB = B[It].GetLocation();
+		const FQuat RotationA = A[It].GetRotation(), RotationB = B[It].GetRotation();
+		const FVector ScaleA = A[It].GetScale3D(), ScaleB = B[It].GetScale3D();
+		if (FMemory::Memcmp(&LocationA, &LocationB, sizeof(FVector)) != 0
+			|| FMemory::Memcmp(&RotationA, &RotationB, sizeof(FQuat)) != 0
+			|| FMemory::Memcmp(&ScaleA, &ScaleB, sizeof(FVector)) != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs AsteroidSpawnerReplayWaveCmd(
+	TEXT("AFPS.AsteroidSpawner.ReplayWave"),
+	TEXT("Check replayable wave determinism: wave transforms around world origin must be equal when calculated twice and after waves 1..Wave-1, and match ExpectedChecksum (hex) if given. Usage: AFPS.AsteroidSpawner.ReplayWave <Wave> [Seed] [ExpectedChecksum]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		AAFPS_GameMode* GM = World ? World->GetAuthGameMode<AAFPS_GameMode>() : nullptr;
+		AAFPS_AsteroidSpawner* Spawner = GM ? GM->GetAsteroidSpawner() : nullptr;
+		if (Spawner == nullptr || Args.Num() == 0)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("[AsteroidSpawner] ReplayWave: no asteroid spawner or wave number"));
+			return;
+		}
+
+		const int32 Wave = FMath::Max(FCString::Atoi(*Args[0]), 1);
+		const int32 Seed = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : Spawner->GetWavesSeed();
+		const bool bHasExpectedChecksum = Args.Num() > 2;
+		const uint32 ExpectedChecksum = bHasExpectedChecksum ? FCString::Strtoui64(*Args[2], nullptr, 16) : 0;
+
+		// direct wave calculation, twice
+		TArray<FTransform> SpawnTransforms;
+		TArray<FTransform> RepeatedTransforms;
+		Spawner->CalcReplayWaveSpawnTransforms(Seed, Wave, FVector::ZeroVector, SpawnTransforms);
+		Spawner->CalcReplayWaveSpawnTransforms(Seed, Wave, FVector::ZeroVector, RepeatedTransforms);
+		const bool bRepeatPassed = AreSpawnTransformsEqual(SpawnTransforms, RepeatedTransforms);
+
+		// same wave after earlier waves, wave must not depend on them
+		TArray<FTransform> ProgressedTransforms;
+		for (int32 It = 1; It <= Wave; ++It)
+		{
+			Spawner->CalcReplayWaveSpawnTransforms(Seed, It, FVector::ZeroVector, ProgressedTransforms);
+		}
+		const bool bProgressPassed = AreSpawnTransformsEqual(SpawnTransforms, ProgressedTransforms);
+
+		const uint32 Checksum = CalcSpawnTransformsChecksum(SpawnTransforms);
+		const bool bChecksumPassed = !bHasExpectedChecksum || Checksum == ExpectedChecksum;
+
+		UE_LOG(LogTemp, Display, TEXT("[AsteroidSpawner] ReplayWave Seed %d Wave %d: %d transforms, checksum %08X, repeat %s, after earlier waves %s, expected checksum %s"),
+			Seed, Wave, SpawnTransforms.Num(), Checksum, bRepeatPassed ? TEXT("OK") : TEXT("MISMATCH"), bProgressPassed ? TEXT("OK") : TEXT("MISMATCH"),
+			bHasExpectedChecksum ? (bChecksumPassed ? TEXT("OK") : TEXT("MISMATCH")) : TEXT("not given"));
+		UE_LOG(LogTemp, Display, TEXT("[AsteroidSpawner] ReplayWave %s"), bRepeatPassed && bProgressPassed && bChecksumPassed ? TEXT("PASSED") : TEXT("FAILED"));
+	})
+);
+
 AAFPS_AsteroidSpawner::AAFPS_AsteroidSpawner()
 {
-	#if WITH_EDITOR
+	// tick is used for spawn queue processing, in editor it's also used for draw debug
 	PrimaryActorTick.bCanEverTick = true;
-	#endif  // WITH_EDITOR
+	#if !WITH_EDITOR
+	PrimaryActorTick.bStartWithTickEnabled = false;
+	#endif  // !WITH_EDITOR
 
 	// defaults
 	SpawnParam.AsteroidClass = AAFPS_Asteroid::StaticClass();
+	SpawnParam.bUseInstancedAsteroidField = false;
+	SpawnParam.AsteroidFieldClass = AAFPS_AsteroidField::StaticClass();
 	SpawnParam.InitialSpawnRadius = 25'00.f;  // 25m
 	SpawnParam.MaxSpawnRadius = 1'000'00.f; // 1km
 	SpawnParam.NextWaveRadiusMult = 1.05f;
@@ -39,15 +139,20 @@ AAFPS_AsteroidSpawner::AAFPS_AsteroidSpawner()
 	SpawnParam.AsteroidKillNrToTriggerNextWave = 10;
 	SpawnParam.AsteroidScaleStep = -0.01;
 	SpawnParam.AsteroidScaleLimit = 0.25;
+	SpawnParam.SpawnBudgetMsPerFrame = 2.f;
+	SpawnParam.RandomSeed = 0;
+	SpawnParam.bReplayableWaves = false;
 
 	bAllowStartWave = true;  // allow execute initial spawn wave
 }
 
 bool AAFPS_AsteroidSpawner::CanSpawnWave()
 {
-	TArray<AActor*> InAsteroidActors;
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), SpawnParam.AsteroidClass, InAsteroidActors);
-	bool bAsteroidSpawnLimitReached = InAsteroidActors.Num() >= SpawnParam.SpawnedAsteroidLimitMax;
+	// live asteroids registry covers pooled asteroids and asteroids placed not by spawner
+	const int32 LiveAsteroidNum = GameMode ? GameMode->GetLiveAsteroidNum() : SpawnedAsteroids.Num();
+	const int32 FieldAsteroidNum = AsteroidField ? AsteroidField->GetAliveInstanceNum() : 0;
+
+	bool bAsteroidSpawnLimitReached = LiveAsteroidNum + FieldAsteroidNum + GetPendingSpawnAsteroidNum() >= SpawnParam.SpawnedAsteroidLimitMax;
 
 	return !bAsteroidSpawnLimitReached && bAllowStartWave;
 }
@@ -60,18 +165,34 @@ void AAFPS_AsteroidSpawner::PrepareFirstWave(AAFPS_GameMode* GM)
 		return;
 	}
 
+	GameMode = GM;
+
 	if (CanSpawnWave())
 	{
 		// subscribe to asteroid kill for checking next spawn wave
-		GM->NotifyActorKilled.AddDynamic(this, &AAFPS_AsteroidSpawner::OnActorKilled);
+		GM->GetKillEventBus().OnKill(EKillVictimCategory::Asteroid).AddUObject(this, &AAFPS_AsteroidSpawner::OnAsteroidKilled);
+
+		// all asteroids are instances of single asteroid field
+		if (SpawnParam.bUseInstancedAsteroidField)
+		{
+			AsteroidField = GetWorld()->SpawnActor<AAFPS_AsteroidField>(SpawnParam.AsteroidFieldClass);
+		}
+
+		// cell size equal to min distance, so spawn point check have to look only at neighbour cells
+		SpawnGrid.Reset(SpawnParam.MinSpawnDistanceBetweenAsteroids);
+
+		// every wave random stream is derived from waves seed
+		WavesSeed = SpawnParam.RandomSeed;
+		while (WavesSeed == 0)
+		{
+			WavesSeed = FMath::Rand();
+		}
 
 		// first wave spawn parameters
 		WaveCount = 1;
-		SpawnRadius = SpawnParam.InitialSpawnRadius;
+		CalcWaveState(WaveCount, SpawnRadius, AsteroidSpawnNum, AsteroidScale);
 		SpawnOrigin = GetNewSpawnOrigin();
 		AsteroidToKillForNextWave = SpawnParam.AsteroidKillNrToTriggerNextWave;
-		AsteroidSpawnNum = SpawnParam.InitialAsteroidSpawnNr;
-		AsteroidScale = 1.0f;
 
 		// run first wave
 		StartWave();
@@ -84,10 +205,9 @@ void AAFPS_AsteroidSpawner::StartNextWave()
 	{
 		// next wave spawn parameters
 		++WaveCount;
-		SpawnRadius = FMath::Min(SpawnRadius * SpawnParam.NextWaveRadiusMult, SpawnParam.MaxSpawnRadius);
+		CalcWaveState(WaveCount, SpawnRadius, AsteroidSpawnNum, AsteroidScale);
 		SpawnOrigin = GetNewSpawnOrigin();
 		AsteroidToKillForNextWave = SpawnParam.AsteroidKillNrToTriggerNextWave;  // reset asteroid to kill nr
-		AsteroidSpawnNum *= SpawnParam.NextWaveAsteroidSpawnNrMult;
 		
 		// run next wave
 		StartWave();
@@ -96,104 +216,209 @@ void AAFPS_AsteroidSpawner::StartNextWave()
 
 void AAFPS_AsteroidSpawner::StartWave()
 {
+	AFPS_SCOPE_STAT(SpawnerStartWave);
+
+	if (GameMode)
+	{
+		GameMode->GetFrameTimeTracker().BeginWave(WaveCount, GFrameCounter);
+	}
+
 	bAllowStartWave = false;
 	
 	//if (GEngine) GEngine->AddOnScreenDebugMessage(INDEX_NONE, 2.f, FColor::Red, "Start Next wave"); // debug
 
-	// spawn asteroids
-	for (int It = 0; It != AsteroidSpawnNum; ++It)
+	// calculate whole wave spawn points at once
+	TArray<FVector> SpawnPoints;
+	if (SpawnParam.bReplayableWaves)
 	{
-		SpawnAsteroid();
+		CalcWaveSpawnPoints(WavesSeed, WaveCount, SpawnOrigin, SpawnRadius, AsteroidSpawnNum, [](const FVector&) { return true; }, SpawnPoints);
 	}
+	else
+	{
+		CalcWaveSpawnPoints(WavesSeed, WaveCount, SpawnOrigin, SpawnRadius, AsteroidSpawnNum,
+			[this](const FVector& Point) { return IsAsteroidSpawnPointValid(Point); }, SpawnPoints);
+	}
+
+	// drop already spawned queue part, so queue doesn't grow through waves
+	PendingSpawns.RemoveAt(0, PendingSpawnIndex, false);
+	PendingSpawnIndex = 0;
+
+	// queue asteroids, queued points are added to grid right away to keep next waves points valid
+	const double QueueTime = FPlatformTime::Seconds();
+	PendingSpawns.Reserve(PendingSpawns.Num() + SpawnPoints.Num());
+	for (const FVector& SpawnPoint : SpawnPoints)
+	{
+		PendingSpawns.Add({ CalcAsteroidSpawnTransform(SpawnPoint, AsteroidScale), QueueTime });
+		SpawnGrid.Add(SpawnPoint);
+	}
+
+	SET_MEMORY_STAT(STAT_AsteroidSpawnQueueMemory, PendingSpawns.GetAllocatedSize());
+	SET_MEMORY_STAT(STAT_AsteroidSpawnGridMemory, SpawnGrid.GetAllocatedSize());
+
+	NotifyWaveStateChanged.Broadcast();
+
+	SetActorTickEnabled(true);
 }
 
-FORCEINLINE FVector AAFPS_AsteroidSpawner::CalcAsteroidSpawnPointOffset()
+void AAFPS_AsteroidSpawner::ProcessSpawnQueue()
 {
-	/*
-	 * Spherical coordinates https://en.wikipedia.org/wiki/Spherical_coordinate_system
-	 *
-	 * SpherePitch(Inclination) = arccos(z / sqrt(x^2+y^2+z^2)) = arccos(z/r) = arctan(sqrt(x^2 + y^2) / z)
-	 * SphereYaw(Azimuth) = arctan(y/x)
-	 *
-	 * x = r * cos(SphereYaw) * sin(SpherePitch)
-	 * y = r * sin(SphereYaw) * sin(SpherePitch)
-	 * z = r * cos(SpherePitch)
-	 */
-
-	// calculate random spawn point from sphere center
-	const float SpherePitch = FMath::FRandRange(-PI * 2.f, PI * 2.f);
-	const float SphereYaw = FMath::FRandRange(-PI * 2.f, PI * 2.f);
-	const float CosSphereYaw = cosf(SphereYaw);
-	const float SinSphereYaw = sinf(SphereYaw);
-	const float CosSpherePitch = cosf(SpherePitch);
-	const float SinSpherePitch = sinf(SpherePitch);
-
-	const FVector SphericalOffset = FVector(
-		SpawnRadius * CosSphereYaw * SinSpherePitch,
-		SpawnRadius * SinSphereYaw * SinSpherePitch,
-		SpawnRadius * CosSpherePitch
-	);
-
-	return SphericalOffset;
+	SCOPE_CYCLE_COUNTER(STAT_AsteroidSpawnQueue);
+
+	const double StartTime = FPlatformTime::Seconds();
+	const double EndTime = StartTime + SpawnParam.SpawnBudgetMsPerFrame * 0.001;
+
+	int32 SpawnedNum = 0;
+	double LatencyMax = 0.0;
+
+	// at least one asteroid per frame, so queue always moves
+	while (PendingSpawnIndex < PendingSpawns.Num() && (SpawnedNum == 0 || FPlatformTime::Seconds() < EndTime))
+	{
+		const FPendingAsteroidSpawn& PendingSpawn = PendingSpawns[PendingSpawnIndex++];
+		LatencyMax = FMath::Max(LatencyMax, StartTime - PendingSpawn.QueueTime);
+
+		SpawnAsteroid(PendingSpawn.Transform);
+		++SpawnedNum;
+	}
+
+	if (PendingSpawnIndex == PendingSpawns.Num())
+	{
+		PendingSpawns.Reset();
+		PendingSpawnIndex = 0;
+
+		#if !WITH_EDITOR
+		SetActorTickEnabled(false);  // nothing to spawn, tick is needed only for draw debug in editor
+		#endif  // !WITH_EDITOR
+	}
+
+	// once per frame for all spawned asteroids
+	NotifyWaveStateChanged.Broadcast();
+
+	SET_DWORD_STAT(STAT_AsteroidSpawnQueueDepth, GetPendingSpawnAsteroidNum());
+	SET_DWORD_STAT(STAT_AsteroidSpawnedPerFrame, SpawnedNum);
+	SET_FLOAT_STAT(STAT_AsteroidSpawnLatency, LatencyMax * 1000.0);
 }
 
-FORCEINLINE bool AAFPS_AsteroidSpawner::IsAsteroidSpawnPointValid(const FVector& InSpawnPoint)
+void AAFPS_AsteroidSpawner::CalcWaveState(int32 Wave, float& OutSpawnRadius, int32& OutAsteroidSpawnNum, float& OutAsteroidScale) const
 {
-	const float SquareDistTreshold = FMath::Square(SpawnParam.MinSpawnDistanceBetweenAsteroids);
-	
-	for (auto& Asteroid : SpawnedAsteroids)
+	OutSpawnRadius = SpawnParam.InitialSpawnRadius;
+	OutAsteroidSpawnNum = SpawnParam.InitialAsteroidSpawnNr;
+
+	// scale is stepped once for every asteroid requested by earlier waves
+	int64 ScaleStepNum = 0;
+	for (int32 It = 1; It < Wave; ++It)
 	{
-		if (Asteroid)
-		{
-			float AsteroidSquareDist = FVector::DistSquared(InSpawnPoint, Asteroid->GetActorLocation());
-			if (AsteroidSquareDist < SquareDistTreshold)
-			{
-				// found one asteroid that is closer then SpawnParam.MinSpawnDistanceBetweenAsteroids
-				return false;
-			}
-		}
+		ScaleStepNum += OutAsteroidSpawnNum;
+
+		OutSpawnRadius = FMath::Min(OutSpawnRadius * SpawnParam.NextWaveRadiusMult, SpawnParam.MaxSpawnRadius);
+		OutAsteroidSpawnNum *= SpawnParam.NextWaveAsteroidSpawnNrMult;
 	}
-	return true;
+
+	// closed form of CalcAsteroidSpawnTransform steps, limit is applied after first step same as there
+	const float SteppedScale = static_cast<float>(1.0 + ScaleStepNum * static_cast<double>(SpawnParam.AsteroidScaleStep));
+	OutAsteroidScale = ScaleStepNum == 0 ? 1.0f : SpawnParam.AsteroidScaleStep > 0.f ?
+		FMath::Min(SteppedScale, FMath::Abs(SpawnParam.AsteroidScaleLimit)) :
+		FMath::Max(SteppedScale, FMath::Abs(SpawnParam.AsteroidScaleLimit));
 }
 
-FTransform AAFPS_AsteroidSpawner::CalcAsteroidSpawnTransform()
+void AAFPS_AsteroidSpawner::CalcWaveSpawnPoints(int32 Seed, int32 Wave, const FVector& Origin, float WaveRadius, int32 WaveAsteroidNum,
+	TFunctionRef<bool(const FVector&)> IsPointAllowed, TArray<FVector>& OutSpawnPoints) const
 {
-	// calculate asteroid spawn position
-	FVector AsteroidOffsetFromSpawnAnchor;
-	FVector AsteroidPosition;
+	FRandomStream WaveStream(GetWaveStreamSeed(Seed, Wave));
 
-	// we use here hack to limit max position adjusting attempts (we don't really want infinity loops)
-	for (int32 Attempt = 0, MaxAttempt = SpawnParam.SpawnPositionAdsjustAttemptsMax; Attempt != MaxAttempt; ++Attempt)
+	// poisson disk sampling keeps SpawnParam.MinSpawnDistanceBetweenAsteroids between wave points,
+	// spawned asteroids are checked by IsPointAllowed
+	FAsteroidSpawnSampler::PoissonDiskSphere(Origin, WaveRadius, 
+		SpawnParam.MinSpawnDistanceBetweenAsteroids, WaveAsteroidNum, SpawnParam.SpawnPositionAdsjustAttemptsMax, WaveStream,
+		IsPointAllowed, OutSpawnPoints);
+
+	#if WITH_EDITOR
+	if (OutSpawnPoints.Num() < WaveAsteroidNum)
+		UE_LOG(LogTemp, Warning, TEXT("[AsteroidSpawner] Can't fit %d asteroids on spawn sphere, spawn %d"), WaveAsteroidNum, OutSpawnPoints.Num());
+	#endif // WITH_EDITOR
+}
+
+int32 AAFPS_AsteroidSpawner::GetWaveStreamSeed(int32 Seed, int32 Wave)
+{
+	// splitmix64 finalizer, neighbour waves get unrelated streams
+	uint64 Hash = (static_cast<uint64>(static_cast<uint32>(Seed)) << 32) | static_cast<uint32>(Wave);
+	Hash += 0x9E3779B97F4A7C15ull;
+	Hash = (Hash ^ (Hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+	Hash = (Hash ^ (Hash >> 27)) * 0x94D049BB133111EBull;
+	Hash ^= Hash >> 31;
+
+	return static_cast<int32>(static_cast<uint32>(Hash));
+}
+
+void AAFPS_AsteroidSpawner::CalcReplayWaveSpawnTransforms(int32 Seed, int32 Wave, const FVector& Origin, TArray<FTransform>& OutSpawnTransforms) const
+{
+	OutSpawnTransforms.Reset();
+
+	if (Wave < 1)
 	{
-		AsteroidOffsetFromSpawnAnchor = CalcAsteroidSpawnPointOffset();
-		AsteroidPosition = AsteroidOffsetFromSpawnAnchor + SpawnOrigin;
-		if (IsAsteroidSpawnPointValid(AsteroidPosition))
-		{
-			// point is valid no need to calculate another one
-			break;
-		}
+		return;
+	}
+
+	float WaveRadius;
+	int32 WaveAsteroidNum;
+	float WaveAsteroidScale;
+	CalcWaveState(Wave, WaveRadius, WaveAsteroidNum, WaveAsteroidScale);
+
+	TArray<FVector> SpawnPoints;
+	CalcWaveSpawnPoints(Seed, Wave, Origin, WaveRadius, WaveAsteroidNum, [](const FVector&) { return true; }, SpawnPoints);
 
-		#if WITH_EDITOR
-		if (Attempt == MaxAttempt - 1) 
-			UE_LOG(LogTemp, Warning, TEXT("[AsteroidSpawner] Can't adjust spawnPosition for Asteroid after %d attempts, spawn wherever"), SpawnParam.SpawnPositionAdsjustAttemptsMax);
-		#endif // WITH_EDITOR
+	OutSpawnTransforms.Reserve(SpawnPoints.Num());
+	for (const FVector& SpawnPoint : SpawnPoints)
+	{
+		OutSpawnTransforms.Add(CalcAsteroidSpawnTransform(SpawnPoint, WaveAsteroidScale));
 	}
+}
 
-	return FTransform(FRotator(), AsteroidPosition, FVector(AsteroidScale));
+FORCEINLINE bool AAFPS_AsteroidSpawner::IsAsteroidSpawnPointValid(const FVector& InSpawnPoint)
+{
+	AFPS_SCOPE_STAT(SpawnerSpawnPointValid);
+
+	return SpawnGrid.IsPointFree(InSpawnPoint, SpawnParam.MinSpawnDistanceBetweenAsteroids);
 }
 
-void AAFPS_AsteroidSpawner::SpawnAsteroid()
+FTransform AAFPS_AsteroidSpawner::CalcAsteroidSpawnTransform(const FVector& InSpawnPoint, float& InOutAsteroidScale) const
 {
-	FTransform SpawnTransform = CalcAsteroidSpawnTransform();
-	AAFPS_Asteroid* SpawnedAsteroid = GetWorld()->SpawnActor<AAFPS_Asteroid>(SpawnParam.AsteroidClass, SpawnTransform);
+	AFPS_SCOPE_STAT(SpawnerCalcSpawnTransform);
 
-	SpawnedAsteroids.Push(SpawnedAsteroid);
-	NotifyAsteroidSpawned.Broadcast(SpawnedAsteroid);
+	FTransform SpawnTransform(FRotator::ZeroRotator, InSpawnPoint, FVector(InOutAsteroidScale));
 
 	// Calculate next spawn asteroid scale
-	AsteroidScale = SpawnParam.AsteroidScaleStep > 0.f ?
-		FMath::Min(AsteroidScale + SpawnParam.AsteroidScaleStep, FMath::Abs(SpawnParam.AsteroidScaleLimit)) : 
-		FMath::Max(AsteroidScale + SpawnParam.AsteroidScaleStep, FMath::Abs(SpawnParam.AsteroidScaleLimit));
+	InOutAsteroidScale = SpawnParam.AsteroidScaleStep > 0.f ?
+		FMath::Min(InOutAsteroidScale + SpawnParam.AsteroidScaleStep, FMath::Abs(SpawnParam.AsteroidScaleLimit)) : 
+		FMath::Max(InOutAsteroidScale + SpawnParam.AsteroidScaleStep, FMath::Abs(SpawnParam.AsteroidScaleLimit));
+
+	return SpawnTransform;
+}
+
+void AAFPS_AsteroidSpawner::SpawnAsteroid(const FTransform& SpawnTransform)
+{
+	if (AsteroidField)
+	{
+		AsteroidField->AddAsteroid(SpawnTransform);
+		NotifyAsteroidSpawned.Broadcast(nullptr);
+		return;
+	}
+
+	UAFPS_AsteroidPoolComponent* AsteroidPool = GameMode ? GameMode->GetAsteroidPool() : nullptr;
+
+	AAFPS_Asteroid* SpawnedAsteroid = AsteroidPool ?
+		AsteroidPool->Acquire(SpawnParam.AsteroidClass, SpawnTransform) :
+		GetWorld()->SpawnActor<AAFPS_Asteroid>(SpawnParam.AsteroidClass, SpawnTransform);
+
+	if (SpawnedAsteroid == nullptr)
+	{
+		SpawnGrid.Remove(SpawnTransform.GetLocation());  // queued point is not occupied any more
+	}
+	else
+	{
+		SpawnedAsteroid->SetSpawnedAsteroidIndex(SpawnedAsteroids.Add(SpawnedAsteroid));
+	}
+
+	NotifyAsteroidSpawned.Broadcast(SpawnedAsteroid);
 }
 
 FVector AAFPS_AsteroidSpawner::GetNewSpawnOrigin()
@@ -216,21 +441,81 @@ FVector AAFPS_AsteroidSpawner::GetNewSpawnOrigin()
 	return NewSpawnOrigin;
 }
 
-void AAFPS_AsteroidSpawner::OnActorKilled(AActor* Victim, AActor* Killer, AController* KillerController)
+bool AAFPS_AsteroidSpawner::RemoveSpawnedAsteroid(AAFPS_Asteroid* Asteroid)
 {
-	if (AAFPS_Asteroid* Asteroid = Cast<AAFPS_Asteroid>(Victim))
+	const int32 Index = Asteroid->GetSpawnedAsteroidIndex();
+	if (!SpawnedAsteroids.IsValidIndex(Index) || SpawnedAsteroids[Index] != Asteroid)
+	{
+		return false;
+	}
+
+	SpawnedAsteroids.RemoveAtSwap(Index, 1, false);
+	if (SpawnedAsteroids.IsValidIndex(Index) && SpawnedAsteroids[Index])
 	{
-		// remove if in SpawnedAsteroids container;
-		SpawnedAsteroids.RemoveSingle(Asteroid);
-		// if asteroid was destroyed and no OnAsteroidKilled is triggered, remove nullptrs
-		SpawnedAsteroids.Remove(nullptr);
+		SpawnedAsteroids[Index]->SetSpawnedAsteroidIndex(Index);  // last asteroid is moved to removed one place
+	}
+	Asteroid->SetSpawnedAsteroidIndex(INDEX_NONE);
+
+	SpawnGrid.Remove(Asteroid->GetActorLocation());
+
+	return true;
+}
 
-		if (--AsteroidToKillForNextWave <= 0)  // decrement asteroid to kill, check if we can start next wave
+void AAFPS_AsteroidSpawner::OnAsteroidKilled(const FKillEvent& KillEvent)
+{
+	if (KillEvent.IsFieldInstance())
+	{
+		AAFPS_AsteroidField* Field = KillEvent.GetAsteroidField();
+		if (Field == AsteroidField)
 		{
-			bAllowStartWave = true;
-			StartNextWave();  // run next wave
+			SpawnGrid.Remove(Field->GetInstanceLocation(KillEvent.InstanceIndex));
 		}
 	}
+	else
+	{
+		RemoveSpawnedAsteroid(KillEvent.GetAsteroid());
+	}
+
+	if (GameMode)
+	{
+		GameMode->GetFrameTimeTracker().NoteKill(GFrameCounter);
+	}
+
+	HandleAsteroidKilled();
+
+	NotifyWaveStateChanged.Broadcast();
+}
+
+void AAFPS_AsteroidSpawner::HandleAsteroidKilled()
+{
+	if (--AsteroidToKillForNextWave <= 0)  // decrement asteroid to kill, check if we can start next wave
+	{
+		bAllowStartWave = true;
+		StartNextWave();  // run next wave
+	}
+}
+
+int32 AAFPS_AsteroidSpawner::GetAliveSpawnedAsteroidNum() const
+{
+	return SpawnedAsteroids.Num() + (AsteroidField ? AsteroidField->GetAliveInstanceNum() : 0);
+}
+
+void AAFPS_AsteroidSpawner::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (PendingSpawnIndex < PendingSpawns.Num())
+	{
+		ProcessSpawnQueue();
+	}
+
+	#if WITH_EDITOR
+	if (CVarDrawDebugAsteroidSpawner.GetValueOnGameThread() && 
+		CVarDrawDebugGlobal.GetValueOnGameThread())
+	{
+		DrawDebug(DeltaSeconds);
+	}
+	#endif // WITH_EDITOR
 }
 
 
@@ -241,13 +526,45 @@ void AAFPS_AsteroidSpawner::DrawDebug(float DeltaSeconds)
 	DrawDebugSphere(GetWorld(), SpawnOrigin, SpawnRadius, 36, FColor::Green);
 
 	// params
-	FString DbgMsg = "WaveCount: " + FString::FromInt(WaveCount)
-		+ "\n SpawnRadius: " + FString::SanitizeFloat(SpawnRadius)
-		+ "\n SpawnOrigin: " + SpawnOrigin.ToString()
-		+ "\n NextWaveKillNeed: " + FString::FromInt(AsteroidToKillForNextWave)
-		+ "\n AsteroidSpawnNum: " + FString::FromInt(AsteroidSpawnNum)
-		+ "\n AsteroidNextScale: " + FString::SanitizeFloat(AsteroidScale)
-		+ "\n SpawnedAsteroidsNum: " + FString::FromInt(SpawnedAsteroids.Num());
+	DebugText.Begin();
+	DebugText.AddLine(TEXT("WaveCount: %d"), WaveCount);
+	DebugText.AddLine(TEXT(" SpawnRadius: %.1f"), SpawnRadius);
+	DebugText.AddLine(TEXT(" SpawnOrigin: X=%.3f Y=%.3f Z=%.3f"), SpawnOrigin.X, SpawnOrigin.Y, SpawnOrigin.Z);
+	DebugText.AddLine(TEXT(" NextWaveKillNeed: %d"), AsteroidToKillForNextWave);
+	DebugText.AddLine(TEXT(" AsteroidSpawnNum: %d"), AsteroidSpawnNum);
+	DebugText.AddLine(TEXT(" PendingSpawnNum: %d"), GetPendingSpawnAsteroidNum());
+	DebugText.AddLine(TEXT(" AsteroidNextScale: %.3f"), AsteroidScale);
+	DebugText.AddLine(TEXT(" SpawnedAsteroidsNum: %d"), GetAliveSpawnedAsteroidNum());
+
+	if (UAFPS_AsteroidSignificanceComponent* Significance = GameMode ? GameMode->GetAsteroidSignificance() : nullptr)
+	{
+		DebugText.AddLine(TEXT(" Significance High/Medium/Low/Culled: %d/%d/%d/%d"),
+			Significance->GetBucketNum(EAsteroidSignificance::High), Significance->GetBucketNum(EAsteroidSignificance::Medium),
+			Significance->GetBucketNum(EAsteroidSignificance::Low), Significance->GetBucketNum(EAsteroidSignificance::Culled));
+		DebugText.AddLine(TEXT(" SignificanceUpdate: %.3f ms (full %.3f ms)"),
+			Significance->GetUpdateSeconds() * 1000.0, Significance->GetFullUpdateSeconds() * 1000.0);
+		DebugText.AddLine(TEXT(" SignificanceSaved: %.3f ms"), Significance->GetSavedSeconds() * 1000.0);
+	}
+
+	if (GameMode)
+	{
+		const FFrameTimeTracker& FrameTimes = GameMode->GetFrameTimeTracker();
+		const FWaveFrameTimeStats WaveFrameTimes = FrameTimes.GetCurrentWaveStats();
+
+		DebugText.AddLine(TEXT(" WaveFrameMs p50/p95/p99: %.1f/%.1f/%.1f max %.1f"),
+			WaveFrameTimes.P50Ms, WaveFrameTimes.P95Ms, WaveFrameTimes.P99Ms, WaveFrameTimes.MaxMs);
+		DebugText.AddLine(TEXT(" WaveSpikes: %d (wave start %d, kill %d)"),
+			WaveFrameTimes.SpikeNum, WaveFrameTimes.WaveStartSpikeNum, WaveFrameTimes.KillSpikeNum);
+
+		if (FrameTimes.GetFinishedWaveStats().Num())
+		{
+			const FWaveFrameTimeStats& LastWaveFrameTimes = FrameTimes.GetFinishedWaveStats().Last();
+			DebugText.AddLine(TEXT(" LastWave %d FrameMs p95: %.1f spikes %d"),
+				LastWaveFrameTimes.Wave, LastWaveFrameTimes.P95Ms, LastWaveFrameTimes.SpikeNum);
+		}
+	}
+
+	DebugText.End();
 
 	if (auto PC = GetWorld()->GetFirstPlayerController())
 	{
@@ -260,16 +577,10 @@ void AAFPS_AsteroidSpawner::DrawDebug(float DeltaSeconds)
 		
 		FVector DbgMsgDrawLoc = ViewPoint + ViewRotMatrix.TransformPosition(MsgCameraOffset);
 
-		DrawDebugString(GetWorld(), DbgMsgDrawLoc, DbgMsg, 0, FColor::Orange, 0.f, true);
-	}
-}
-
-void AAFPS_AsteroidSpawner::Tick(float DeltaSeconds)
-{
-	if (CVarDrawDebugAsteroidSpawner.GetValueOnGameThread() && 
-		CVarDrawDebugGlobal.GetValueOnGameThread())
-	{
-		DrawDebug(DeltaSeconds);
+		if (AAFPS_HUD* HUD = Cast<AAFPS_HUD>(PC->GetHUD()))
+		{
+			HUD->AddDebugText(this, DebugText, DbgMsgDrawLoc, FColor::Orange);
+		}
 	}
 }
 #endif // WITH_EDITOR
@@ -0,0 +1,247 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AFPS_AsteroidSpinSystem.h"
+
+#include <FPS_Asteroid/FPS_Asteroid.h>
+
+DECLARE_CYCLE_STAT(TEXT("Asteroid Spin Integrate"), STAT_AsteroidSpinIntegrate, STATGROUP_FPSAsteroid);
+
+static FAutoConsoleCommand AsteroidSpinBenchmarkCmd(
+	TEXT("AFPS.AsteroidSpin.BenchmarkIntegrate"),
+	TEXT("Time spin integrator kernel against per asteroid FQuat integration at 1k, 10k and 100k spinning asteroids. Usage: AFPS.AsteroidSpin.BenchmarkIntegrate [Frames]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 FrameNum = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 100;
+		const float DeltaSeconds = 1.f / 60.f;
+
+		FRandomStream Stream(1);
+		FAsteroidSpinSystem SpinSystem;
+		TArray<FQuat> Rotations;
+		TArray<FVector> AngularVelocities;
+
+		for (const int32 AsteroidNum : { 1000, 10000, 100000 })
+		{
+			SpinSystem.Reset();
+			Rotations.Reset(AsteroidNum);
+			AngularVelocities.Reset(AsteroidNum);
+			for (int32 It = 0; It != AsteroidNum; ++It)
+			{
+				const FQuat Rotation(Stream.GetUnitVector(), Stream.FRandRange(-PI, PI));
+				const FVector AngularVelocity = Stream.GetUnitVector() * Stream.FRandRange(0.1f, 2.f * PI);
+				Rotations.Add(Rotation);
+				AngularVelocities.Add(AngularVelocity);
+				SpinSystem.Add(Rotation, AngularVelocity);
+			}
+
+			// array of structures, one quaternion product per asteroid, as actors were spun
+			double StartTime = FPlatformTime::Seconds();
+			for (int32 Frame = 0; Frame != FrameNum; ++Frame)
+			{
+				for (int32 It = 0; It != AsteroidNum; ++It)
+				{
+					const float Speed = AngularVelocities[It].Size();
+					Rotations[It] = FQuat(AngularVelocities[It] / Speed, Speed * DeltaSeconds) * Rotations[It];
+					Rotations[It].Normalize();
+				}
+			}
+			const double ScalarMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / FrameNum;
+
+			StartTime = FPlatformTime::Seconds();
+			for (int32 Frame = 0; Frame != FrameNum; ++Frame)
+			{
+				SpinSystem.Integrate(DeltaSeconds);
+			}
+			const double KernelMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / FrameNum;
+
+			// both paths integrate same rotations, difference is float error only
+			float MaxErrorDegrees = 0.f;
+			for (int32 It = 0; It != AsteroidNum; ++It)
+			{
+				MaxErrorDegrees = FMath::Max(MaxErrorDegrees, FMath::RadiansToDegrees(SpinSystem.GetRotation(It).AngularDistance(Rotations[It])));
+			}
+
+			UE_LOG(LogTemp, Display, TEXT("[AsteroidSpin] %d asteroids, %d frames: FQuat %.3f ms, kernel %.3f ms per frame (x%.1f, %.1f ns per asteroid), max error %.4f deg%s"),
+				AsteroidNum, FrameNum, ScalarMs, KernelMs, KernelMs > 0.0 ? ScalarMs / KernelMs : 0.0, KernelMs * 1000000.0 / AsteroidNum,
+				MaxErrorDegrees, MaxErrorDegrees > 0.1f ? TEXT(" MISMATCH") : TEXT(""));
+		}
+	})
+);
+
+int32 FAsteroidSpinSystem::Add(const FQuat& Rotation, const FVector& AngularVelocity)
+{
+	RotX.Add(Rotation.X);
+	RotY.Add(Rotation.Y);
+	RotZ.Add(Rotation.Z);
+	RotW.Add(Rotation.W);
+	AngVelX.Add(0.f);
+	AngVelY.Add(0.f);
+	AngVelZ.Add(0.f);
+
+	const int32 Index = RotX.Num() - 1;
+	AddAngularVelocity(Index, AngularVelocity);
+	return Index;
+}
+
+void FAsteroidSpinSystem::RemoveAtSwap(int32 Index)
+{
+	StopSpin(Index);
+
+	RotX.RemoveAtSwap(Index, 1, false);
+	RotY.RemoveAtSwap(Index, 1, false);
+	RotZ.RemoveAtSwap(Index, 1, false);
+	RotW.RemoveAtSwap(Index, 1, false);
+	AngVelX.RemoveAtSwap(Index, 1, false);
+	AngVelY.RemoveAtSwap(Index, 1, false);
+	AngVelZ.RemoveAtSwap(Index, 1, false);
+}
+
+void FAsteroidSpinSystem::Reset()
+{
+	RotX.Reset();
+	RotY.Reset();
+	RotZ.Reset();
+	RotW.Reset();
+	AngVelX.Reset();
+	AngVelY.Reset();
+	AngVelZ.Reset();
+	SpinningNum = 0;
+}
+
+void FAsteroidSpinSystem::Set(int32 Index, const FQuat& Rotation, const FVector& AngularVelocity)
+{
+	RotX[Index] = Rotation.X;
+	RotY[Index] = Rotation.Y;
+	RotZ[Index] = Rotation.Z;
+	RotW[Index] = Rotation.W;
+
+	StopSpin(Index);
+	AddAngularVelocity(Index, AngularVelocity);
+}
+
+void FAsteroidSpinSystem::AddAngularVelocity(int32 Index, const FVector& DeltaAngularVelocity)
+{
+	const bool bWasSpinning = IsSpinning(Index);
+
+	AngVelX[Index] += DeltaAngularVelocity.X;
+	AngVelY[Index] += DeltaAngularVelocity.Y;
+	AngVelZ[Index] += DeltaAngularVelocity.Z;
+
+	SpinningNum += static_cast<int32>(IsSpinning(Index)) - static_cast<int32>(bWasSpinning);
+}
+
+void FAsteroidSpinSystem::StopSpin(int32 Index)
+{
+	SpinningNum -= static_cast<int32>(IsSpinning(Index));
+
+	AngVelX[Index] = 0.f;
+	AngVelY[Index] = 0.f;
+	AngVelZ[Index] = 0.f;
+}
+
+bool FAsteroidSpinSystem::Integrate(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AsteroidSpinIntegrate);
+
+	if (SpinningNum == 0)
+	{
+		return false;
+	}
+
+	float* RESTRICT QX = RotX.GetData();
+	float* RESTRICT QY = RotY.GetData();
+	float* RESTRICT QZ = RotZ.GetData();
+	float* RESTRICT QW = RotW.GetData();
+	const float* RESTRICT WX = AngVelX.GetData();
+	const float* RESTRICT WY = AngVelY.GetData();
+	const float* RESTRICT WZ = AngVelZ.GetData();
+
+	const int32 AsteroidNum = Num();
+	const int32 VectorNum = AsteroidNum & ~3;
+
+	// delta rotation D = (W / |W| * sin(h), cos(h)), h = |W| * dt / 2, new rotation Q' = D * Q
+	const VectorRegister HalfDeltaTime = VectorSetFloat1(0.5f * DeltaSeconds);
+	const VectorRegister SmallNumber = VectorSetFloat1(SMALL_NUMBER);
+
+	int32 It = 0;
+	for (; It != VectorNum; It += 4)
+	{
+		const VectorRegister VWX = VectorLoad(WX + It);
+		const VectorRegister VWY = VectorLoad(WY + It);
+		const VectorRegister VWZ = VectorLoad(WZ + It);
+
+		// 1/|W| clamped, zero angular velocity gives zero axis and sin(0) anyway
+		const VectorRegister SpeedSq = VectorMax(VectorMultiplyAdd(VWZ, VWZ, VectorMultiplyAdd(VWY, VWY, VectorMultiply(VWX, VWX))), SmallNumber);
+		const VectorRegister InvSpeed = VectorReciprocalSqrtAccurate(SpeedSq);
+		const VectorRegister HalfAngle = VectorMultiply(VectorMultiply(SpeedSq, InvSpeed), HalfDeltaTime);
+
+		VectorRegister Sin, Cos;
+		VectorSinCos(&Sin, &Cos, &HalfAngle);
+
+		const VectorRegister AxisScale = VectorMultiply(Sin, InvSpeed);
+		const VectorRegister DX = VectorMultiply(VWX, AxisScale);
+		const VectorRegister DY = VectorMultiply(VWY, AxisScale);
+		const VectorRegister DZ = VectorMultiply(VWZ, AxisScale);
+		const VectorRegister DW = Cos;
+
+		const VectorRegister VQX = VectorLoad(QX + It);
+		const VectorRegister VQY = VectorLoad(QY + It);
+		const VectorRegister VQZ = VectorLoad(QZ + It);
+		const VectorRegister VQW = VectorLoad(QW + It);
+
+		// hamilton product D * Q
+		VectorRegister NX = VectorMultiply(DW, VQX);
+		NX = VectorMultiplyAdd(DX, VQW, NX);
+		NX = VectorMultiplyAdd(DY, VQZ, NX);
+		NX = VectorSubtract(NX, VectorMultiply(DZ, VQY));
+
+		VectorRegister NY = VectorMultiply(DW, VQY);
+		NY = VectorSubtract(NY, VectorMultiply(DX, VQZ));
+		NY = VectorMultiplyAdd(DY, VQW, NY);
+		NY = VectorMultiplyAdd(DZ, VQX, NY);
+
+		VectorRegister NZ = VectorMultiply(DW, VQZ);
+		NZ = VectorMultiplyAdd(DX, VQY, NZ);
+		NZ = VectorSubtract(NZ, VectorMultiply(DY, VQX));
+		NZ = VectorMultiplyAdd(DZ, VQW, NZ);
+
+		VectorRegister NW = VectorMultiply(DW, VQW);
+		NW = VectorSubtract(NW, VectorMultiply(DX, VQX));
+		NW = VectorSubtract(NW, VectorMultiply(DY, VQY));
+		NW = VectorSubtract(NW, VectorMultiply(DZ, VQZ));
+
+		// renormalize to avoid drift
+		const VectorRegister LengthSq = VectorMultiplyAdd(NW, NW, VectorMultiplyAdd(NZ, NZ, VectorMultiplyAdd(NY, NY, VectorMultiply(NX, NX))));
+		const VectorRegister InvLength = VectorReciprocalSqrtAccurate(VectorMax(LengthSq, SmallNumber));
+
+		VectorStore(VectorMultiply(NX, InvLength), QX + It);
+		VectorStore(VectorMultiply(NY, InvLength), QY + It);
+		VectorStore(VectorMultiply(NZ, InvLength), QZ + It);
+		VectorStore(VectorMultiply(NW, InvLength), QW + It);
+	}
+
+	// tail
+	for (; It != AsteroidNum; ++It)
+	{
+		const FVector AngularVelocity(WX[It], WY[It], WZ[It]);
+		const float Speed = AngularVelocity.Size();
+		if (Speed > SMALL_NUMBER)
+		{
+			FQuat Rotation = FQuat(AngularVelocity / Speed, Speed * DeltaSeconds) * FQuat(QX[It], QY[It], QZ[It], QW[It]);
+			Rotation.Normalize();
+
+			QX[It] = Rotation.X;
+			QY[It] = Rotation.Y;
+			QZ[It] = Rotation.Z;
+			QW[It] = Rotation.W;
+		}
+	}
+
+	return true;
+}
+
+SIZE_T FAsteroidSpinSystem::GetAllocatedSize() const
+{
+	return RotX.GetAllocatedSize() + RotY.GetAllocatedSize() + RotZ.GetAllocatedSize() + RotW.GetAllocatedSize()
+		+ AngVelX.GetAllocatedSize() + AngVelY.GetAllocatedSize() + AngVelZ.GetAllocatedSize();
+}
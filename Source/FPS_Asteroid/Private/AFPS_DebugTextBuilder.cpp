@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AFPS_DebugTextBuilder.h"
+#include "CanvasItem.h"
+#include "Engine/Engine.h"
+
+#include <FPS_Asteroid/FPS_Asteroid.h>
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Debug Text Lines Formatted"), STAT_DebugTextLinesFormatted, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Debug Text Rebuilds"), STAT_DebugTextRebuilds, STATGROUP_FPSAsteroid);
+
+constexpr int32 FDebugTextBuilder::MaxLines;
+constexpr int32 FDebugTextBuilder::MaxLineLen;
+constexpr int32 FDebugTextBuilder::MaxKeySize;
+
+#if !UE_BUILD_SHIPPING
+/**
+ * Fewest allocations of single Body call over FrameNum calls, engine malloc counters see all threads,
+ * other threads can only add to a frame, so minimum is game thread count of steady state frame
+ */
+template <typename BodyType>
+static uint64 CountMinFrameAllocations(int32 FrameNum, BodyType Body)
+{
+	uint64 MinAllocNum = MAX_uint64;
+	for (int32 Frame = 0; Frame != FrameNum; ++Frame)
+	{
+		const uint64 StartAllocNum = FMalloc::TotalMallocCalls + FMalloc::TotalReallocCalls;
+		Body(Frame);
+		MinAllocNum = FMath::Min(MinAllocNum, FMalloc::TotalMallocCalls + FMalloc::TotalReallocCalls - StartAllocNum);
+	}
+	return MinAllocNum;
+}
+
+static FAutoConsoleCommand DebugTextAllocationsTestCmd(
+	TEXT("AFPS.DebugText.TestAllocations"),
+	TEXT("Count allocations per frame of weapon overlay text path (builder and HUD canvas text item) against DrawDebugString path (FString::Printf, HUD text copy and canvas FText), with unchanged and changing values. Usage: AFPS.DebugText.TestAllocations [Frames]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 FrameNum = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 600;
+
+		// changing values repeat with warm up period, so text never grows after warm up
+		static constexpr int32 WarmUpFrames = 64;
+		const UFont* Font = GEngine ? GEngine->GetSmallFont() : nullptr;
+
+		// AAFPS_Weapon::DrawDebug lines and AAFPS_HUD::DrawDebugTexts text item
+		FDebugTextBuilder Builder;
+		auto DrawBuilderFrame = [&Builder, Font](int32 Frame, bool bChanging)
+		{
+			const int32 Phase = bChanging ? Frame % WarmUpFrames : 0;
+			Builder.Begin();
+			Builder.AddLine(TEXT("bWantsToFire: %s"), Phase & 1 ? TEXT("true") : TEXT("false"));
+			Builder.AddLine(TEXT("bIsFiring: %s"), Phase & 1 ? TEXT("true") : TEXT("false"));
+			Builder.AddLine(TEXT("EnergyCurrent: %.3f"), 1.f - Phase * 0.01f);
+			Builder.AddLine(TEXT("EnergyLimit: %.3f"), 1.f);
+			Builder.AddLine(TEXT("ShotsLeft: %d"), 100 - Phase);
+			Builder.AddLine(TEXT("NextShotIn: %.3f"), Phase * 0.001f);
+			Builder.AddLine(TEXT("RecentFrameMs p50/p95/p99: %.1f/%.1f/%.1f"), 16.f + Phase * 0.1f, 18.f, 21.f);
+			Builder.End();
+
+			FCanvasTextItem TextItem(FVector2D::ZeroVector, Builder.GetDisplayText(), Font, FLinearColor::White);
+			TextItem.EnableShadow(FLinearColor::Black);
+		};
+
+		// same lines through DrawDebugString: formatted text, AHUD::AddDebugText copy, UCanvas::DrawText FText
+		auto DrawPrintfFrame = [Font](int32 Frame, bool bChanging)
+		{
+			const int32 Phase = bChanging ? Frame % WarmUpFrames : 0;
+			FString Text = FString::Printf(TEXT("bWantsToFire: %s"), Phase & 1 ? TEXT("true") : TEXT("false"));
+			Text += FString::Printf(TEXT("\nbIsFiring: %s"), Phase & 1 ? TEXT("true") : TEXT("false"));
+			Text += FString::Printf(TEXT("\nEnergyCurrent: %.3f"), 1.f - Phase * 0.01f);
+			Text += FString::Printf(TEXT("\nEnergyLimit: %.3f"), 1.f);
+			Text += FString::Printf(TEXT("\nShotsLeft: %d"), 100 - Phase);
+			Text += FString::Printf(TEXT("\nNextShotIn: %.3f"), Phase * 0.001f);
+			Text += FString::Printf(TEXT("\nRecentFrameMs p50/p95/p99: %.1f/%.1f/%.1f"), 16.f + Phase * 0.1f, 18.f, 21.f);
+
+			const FString HUDText = Text;
+			FCanvasTextItem TextItem(FVector2D::ZeroVector, FText::FromString(HUDText), Font, FLinearColor::White);
+			TextItem.EnableShadow(FLinearColor::Black);
+		};
+
+		uint64 AllocNums[2][2];
+		for (const bool bChanging : { false, true })
+		{
+			for (int32 Frame = 0; Frame != WarmUpFrames; ++Frame)
+			{
+				DrawBuilderFrame(Frame, bChanging);
+			}
+
+			AllocNums[bChanging][0] = CountMinFrameAllocations(FrameNum, [&DrawBuilderFrame, bChanging](int32 Frame) { DrawBuilderFrame(Frame, bChanging); });
+			AllocNums[bChanging][1] = CountMinFrameAllocations(FrameNum, [&DrawPrintfFrame, bChanging](int32 Frame) { DrawPrintfFrame(Frame, bChanging); });
+		}
+
+		// allocator that doesn't count calls reports zero for printf path too
+		const bool bCounted = AllocNums[false][1] != 0;
+		const TCHAR* Result = !bCounted ? TEXT("INCONCLUSIVE (allocator doesn't count malloc calls)") : AllocNums[false][0] == 0 ? TEXT("PASSED") : TEXT("FAILED");
+
+		UE_LOG(LogTemp, Display, TEXT("[DebugText] %s %d frames after %d warm up, allocations per frame: unchanged values builder %llu, DrawDebugString %llu; changing values builder %llu (display text only), DrawDebugString %llu"),
+			Result, FrameNum, WarmUpFrames, AllocNums[false][0], AllocNums[false][1], AllocNums[true][0], AllocNums[true][1]);
+	})
+);
+#endif  // !UE_BUILD_SHIPPING
+
+void FDebugTextBuilder::Begin()
+{
+	LineNum = 0;
+}
+
+void FDebugTextBuilder::OnLineFormatted()
+{
+	bDirty = true;
+	INC_DWORD_STAT(STAT_DebugTextLinesFormatted);
+}
+
+const FString& FDebugTextBuilder::End()
+{
+	if (!bDirty && LineNum == BuiltLineNum)
+	{
+		return Text;
+	}
+
+	int32 TextLen = 0;
+	for (int32 It = 0; It != LineNum; ++It)
+	{
+		TextLen += Lines[It].TextLen + 1;
+	}
+
+	// reset keeps allocation, text grows only until longest text is built
+	Text.Reset(TextLen);
+	for (int32 It = 0; It != LineNum; ++It)
+	{
+		if (It)
+		{
+			Text.AppendChar(TEXT('\n'));
+		}
+		Text.AppendChars(Lines[It].Text, Lines[It].TextLen);
+	}
+
+	DisplayText = FText::FromString(Text);
+
+	BuiltLineNum = LineNum;
+	bDirty = false;
+
+	INC_DWORD_STAT(STAT_DebugTextRebuilds);
+
+	return Text;
+}
@@ -0,0 +1,171 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AFPS_FrameTimeTracker.h"
+
+#include "Misc/FileHelper.h"
+
+namespace FrameTimeTracker
+{
+	enum EFrameFlags : uint8
+	{
+		Spike = 1 << 0,
+		WaveStart = 1 << 1,
+		Kill = 1 << 2,
+	};
+
+	/** Events noted before tracking has begun are never attributed */
+	static constexpr uint64 NoEventFrame = MAX_uint64 / 2;
+}
+
+constexpr int32 FFrameTimeTracker::RingSize;
+constexpr float FFrameTimeTracker::HistogramBinMs;
+constexpr int32 FFrameTimeTracker::HistogramBinNum;
+
+FFrameTimeTracker::FFrameTimeTracker()
+	: RingNum(0)
+	, AverageMs(0.f)
+	, LastWaveStartFrame(FrameTimeTracker::NoEventFrame)
+	, LastKillFrame(FrameTimeTracker::NoEventFrame)
+{
+	FMemory::Memzero(Histogram);
+	FinishedWaveStats.Reserve(64);
+}
+
+void FFrameTimeTracker::BeginWave(int32 Wave, uint64 Frame)
+{
+	if (CurrentWave.FrameNum)
+	{
+		FinishedWaveStats.Add(GetCurrentWaveStats());
+	}
+
+	FMemory::Memzero(Histogram);
+	CurrentWave = FWaveFrameTimeStats();
+	CurrentWave.Wave = Wave;
+
+	LastWaveStartFrame = Frame;
+}
+
+void FFrameTimeTracker::NoteKill(uint64 Frame)
+{
+	LastKillFrame = Frame;
+}
+
+void FFrameTimeTracker::AddFrame(float FrameMs, uint64 Frame)
+{
+	uint8 Flags = 0;
+
+	// first frames only set average
+	const bool bSpike = RingNum > 0 && FrameMs > SpikeMinMs && FrameMs > AverageMs * SpikeFactor;
+	if (bSpike)
+	{
+		Flags |= FrameTimeTracker::Spike;
+		++CurrentWave.SpikeNum;
+
+		if (Frame - LastWaveStartFrame <= static_cast<uint64>(AttributionFrames))
+		{
+			Flags |= FrameTimeTracker::WaveStart;
+			++CurrentWave.WaveStartSpikeNum;
+		}
+		else if (Frame - LastKillFrame <= static_cast<uint64>(AttributionFrames))
+		{
+			Flags |= FrameTimeTracker::Kill;
+			++CurrentWave.KillSpikeNum;
+		}
+	}
+	else
+	{
+		AverageMs = RingNum > 0 ? FMath::Lerp(AverageMs, FrameMs, 0.05f) : FrameMs;
+	}
+
+	const int32 RingIndex = static_cast<int32>(RingNum % RingSize);
+	RingFrameMs[RingIndex] = FrameMs;
+	RingFlags[RingIndex] = Flags;
+	++RingNum;
+
+	++Histogram[FMath::Clamp(FMath::FloorToInt(FrameMs / HistogramBinMs), 0, HistogramBinNum - 1)];
+	++CurrentWave.FrameNum;
+	CurrentWave.MaxMs = FMath::Max(CurrentWave.MaxMs, FrameMs);
+}
+
+FWaveFrameTimeStats FFrameTimeTracker::GetCurrentWaveStats() const
+{
+	FWaveFrameTimeStats Stats = CurrentWave;
+	Stats.P50Ms = CalcHistogramPercentileMs(0.5f);
+	Stats.P95Ms = CalcHistogramPercentileMs(0.95f);
+	Stats.P99Ms = CalcHistogramPercentileMs(0.99f);
+
+	return Stats;
+}
+
+float FFrameTimeTracker::CalcHistogramPercentileMs(float Percent) const
+{
+	if (CurrentWave.FrameNum == 0)
+	{
+		return 0.f;
+	}
+
+	// upper bin edge, last bin holds all long frames so max is used
+	const uint32 TargetCount = FMath::Max(FMath::CeilToInt(CurrentWave.FrameNum * Percent), 1);
+	uint32 Count = 0;
+	for (int32 Bin = 0; Bin != HistogramBinNum - 1; ++Bin)
+	{
+		Count += Histogram[Bin];
+		if (Count >= TargetCount)
+		{
+			return FMath::Min((Bin + 1) * HistogramBinMs, CurrentWave.MaxMs);
+		}
+	}
+
+	return CurrentWave.MaxMs;
+}
+
+float FFrameTimeTracker::CalcRecentPercentileMs(float Percent) const
+{
+	const int32 Num = GetRecentFrameNum();
+	if (Num == 0)
+	{
+		return 0.f;
+	}
+
+	FMemory::Memcpy(RingSortBuffer, RingFrameMs, Num * sizeof(float));
+	Sort(RingSortBuffer, Num);
+
+	return RingSortBuffer[FMath::Clamp(FMath::CeilToInt(Num * Percent) - 1, 0, Num - 1)];
+}
+
+bool FFrameTimeTracker::ExportCsv(const FString& WavesPath, const FString& FramesPath) const
+{
+	FString WavesCsv = TEXT("Wave,Frames,P50Ms,P95Ms,P99Ms,MaxMs,Spikes,WaveStartSpikes,KillSpikes\n");
+
+	auto AppendWave = [&WavesCsv](const FWaveFrameTimeStats& Stats)
+	{
+		WavesCsv += FString::Printf(TEXT("%d,%d,%.2f,%.2f,%.2f,%.2f,%d,%d,%d\n"), Stats.Wave, Stats.FrameNum, Stats.P50Ms, Stats.P95Ms, Stats.P99Ms,
+			Stats.MaxMs, Stats.SpikeNum, Stats.WaveStartSpikeNum, Stats.KillSpikeNum);
+	};
+
+	for (const FWaveFrameTimeStats& Stats : FinishedWaveStats)
+	{
+		AppendWave(Stats);
+	}
+	if (CurrentWave.FrameNum)
+	{
+		AppendWave(GetCurrentWaveStats());
+	}
+
+	// recent frames, oldest first
+	FString FramesCsv = TEXT("Frame,FrameMs,Spike,WaveStart,Kill\n");
+
+	const int32 Num = GetRecentFrameNum();
+	for (int32 It = 0; It != Num; ++It)
+	{
+		const uint64 FrameIndex = RingNum - Num + It;
+		const int32 RingIndex = static_cast<int32>(FrameIndex % RingSize);
+		const uint8 Flags = RingFlags[RingIndex];
+
+		FramesCsv += FString::Printf(TEXT("%llu,%.3f,%d,%d,%d\n"), FrameIndex, RingFrameMs[RingIndex],
+			(Flags & FrameTimeTracker::Spike) != 0, (Flags & FrameTimeTracker::WaveStart) != 0, (Flags & FrameTimeTracker::Kill) != 0);
+	}
+
+	return FFileHelper::SaveStringToFile(WavesCsv, *WavesPath) && FFileHelper::SaveStringToFile(FramesCsv, *FramesPath);
+}
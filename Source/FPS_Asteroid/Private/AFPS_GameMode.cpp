@@ -4,39 +4,377 @@
 #include "AFPS_GameMode.h"
 
 #include "AFPS_AsteroidSpawner.h"
+#include "AFPS_AsteroidField.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Components/AFPS_AsteroidPoolComponent.h"
+#include "Components/AFPS_DamageQueueComponent.h"
+#include "Components/AFPS_AsteroidPhysicsLODComponent.h"
+#include "Components/AFPS_AsteroidSpinComponent.h"
+#include "Components/AFPS_AsteroidSignificanceComponent.h"
+#include "Components/AFPS_BenchmarkComponent.h"
 
+#include <FPS_Asteroid/FPS_Asteroid.h>
 #include <FPS_Asteroid/Public/AFPS_Asteroid.h>
 
+DECLARE_CYCLE_STAT(TEXT("Asteroid Ray Caster Build"), STAT_AsteroidRayCasterBuild, STATGROUP_FPSAsteroid);
+DECLARE_CYCLE_STAT(TEXT("Asteroid Raycast"), STAT_AsteroidRaycast, STATGROUP_FPSAsteroid);
+DECLARE_CYCLE_STAT(TEXT("Asteroid Raycast Refine"), STAT_AsteroidRaycastRefine, STATGROUP_FPSAsteroid);
+DECLARE_MEMORY_STAT(TEXT("Asteroid Ray Caster"), STAT_AsteroidRayCasterMemory, STATGROUP_FPSAsteroid);
+
+TAutoConsoleVariable<bool> CVarExportFrameTimesOnEndPlay(
+	TEXT("AFPS.FrameTime.ExportOnEndPlay"),
+	false,
+	TEXT("Enable/Disable frame time tracker CSV export to Saved/Profiling when session ends"),
+	ECVF_Default
+);
+
+static FAutoConsoleCommandWithWorld FrameTimeExportCmd(
+	TEXT("AFPS.FrameTime.Export"),
+	TEXT("Write frame time tracker per wave percentiles and recent frames to Saved/Profiling CSV files"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		AAFPS_GameMode* GM = World ? World->GetAuthGameMode<AAFPS_GameMode>() : nullptr;
+		if (GM)
+		{
+			GM->ExportFrameTimes();
+		}
+	})
+);
+
 AAFPS_GameMode::AAFPS_GameMode()
 {
+	// tick feeds frame time tracker, base game mode doesn't tick
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = true;
+
 	// defaults
 	AsteroidSpawnerClass = AAFPS_AsteroidSpawner::StaticClass();
+
+	// asteroid pool
+	AsteroidPool = CreateDefaultSubobject<UAFPS_AsteroidPoolComponent>(TEXT("AsteroidPool"));
+	bUseAsteroidPool = true;
+
+	// batched damage
+	DamageQueue = CreateDefaultSubobject<UAFPS_DamageQueueComponent>(TEXT("DamageQueue"));
+	bUseDamageQueue = true;
+
+	// asteroid bodies sleep
+	AsteroidPhysicsLOD = CreateDefaultSubobject<UAFPS_AsteroidPhysicsLODComponent>(TEXT("AsteroidPhysicsLOD"));
+	bUseAsteroidPhysicsLOD = true;
+
+	// asteroid spin without physics simulation
+	AsteroidSpin = CreateDefaultSubobject<UAFPS_AsteroidSpinComponent>(TEXT("AsteroidSpin"));
+	bUseAnalyticAsteroidSpin = false;
+
+	// asteroid significance
+	AsteroidSignificance = CreateDefaultSubobject<UAFPS_AsteroidSignificanceComponent>(TEXT("AsteroidSignificance"));
+	bUseAsteroidSignificance = true;
+
+	// headless benchmark
+	Benchmark = CreateDefaultSubobject<UAFPS_BenchmarkComponent>(TEXT("Benchmark"));
+
+	bAsteroidRayCasterDirty = true;
+	AsteroidRayCasterBuildFrame = MAX_uint64;
 }
 
 void AAFPS_GameMode::StartPlay()
 {
 	Super::StartPlay();
 
+	AsteroidPhysicsLOD->SetComponentTickEnabled(bUseAsteroidPhysicsLOD);
+	AsteroidSpin->SetComponentTickEnabled(bUseAnalyticAsteroidSpin);
+	AsteroidSignificance->SetComponentTickEnabled(bUseAsteroidSignificance);
+
 	// create asteroid spawner instance
 	AsteroidSpawner = GetWorld()->SpawnActor<AAFPS_AsteroidSpawner>(AsteroidSpawnerClass);
 	if (AsteroidSpawner)
 	{
+		// spawn all asteroids we can have on scene before first wave, so waves only reuse them
+		const FAsteroidSpawnerParam& SpawnParam = AsteroidSpawner->GetSpawnParam();
+		UAFPS_AsteroidPoolComponent* Pool = GetAsteroidPool();
+		if (Pool && !SpawnParam.bUseInstancedAsteroidField)
+		{
+			Pool->Prewarm(SpawnParam.AsteroidClass, SpawnParam.SpawnedAsteroidLimitMax);
+		}
+
+		// benchmark waves must be same run to run
+		if (Benchmark->IsBenchmarkRequested())
+		{
+			AsteroidSpawner->SetRandomSeed(Benchmark->GetSeed());
+		}
+
 		AsteroidSpawner->PrepareFirstWave(this);
 		AsteroidSpawner->NotifyAsteroidSpawned.AddDynamic(this, &AAFPS_GameMode::OnAsteroidSpawned);
 
+		NotifyAsteroidSpawnerCreated.Broadcast();
+
 		// debug
 		// if (GEngine) GEngine->AddOnScreenDebugMessage(INDEX_NONE, 2.f, FColor::Green, "GM Prep first wave");
 	}
 
-	NotifyActorKilled.AddDynamic(this, &AAFPS_GameMode::OnActorKilled);
+	KillEventBus.OnKill(EKillVictimCategory::Asteroid).AddUObject(this, &AAFPS_GameMode::OnAsteroidKilled);
 }
 
-void AAFPS_GameMode::OnActorKilled(AActor* Victim, AActor* Killer, AController* KillerController)
+void AAFPS_GameMode::Tick(float DeltaSeconds)
 {
-	if (Cast<AAFPS_Asteroid>(Victim))
+	Super::Tick(DeltaSeconds);
+
+	// real time of previous frame, not dilated
+	FrameTimeTracker.AddFrame(FApp::GetDeltaTime() * 1000.0, GFrameCounter);
+}
+
+void AAFPS_GameMode::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (CVarExportFrameTimesOnEndPlay.GetValueOnGameThread())
 	{
-		++KilledAsteroidNum;
+		ExportFrameTimes();
 	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+bool AAFPS_GameMode::ExportFrameTimes() const
+{
+	const FString BasePath = FPaths::ProfilingDir() / TEXT("FrameTimes_") + FDateTime::Now().ToString();
+	const bool bExported = FrameTimeTracker.ExportCsv(BasePath + TEXT("_Waves.csv"), BasePath + TEXT("_Frames.csv"));
+
+	if (bExported)
+	{
+		UE_LOG(LogTemp, Display, TEXT("[GameMode] Frame times exported to %s_*.csv"), *BasePath);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("[GameMode] Can't export frame times to %s_*.csv"), *BasePath);
+	}
+
+	return bExported;
+}
+
+void AAFPS_GameMode::RegisterLiveAsteroid(AAFPS_Asteroid* Asteroid)
+{
+	if (Asteroid && Asteroid->GetLiveAsteroidIndex() == INDEX_NONE)
+	{
+		Asteroid->SetLiveAsteroidIndex(LiveAsteroids.Add(Asteroid));
+		LiveAsteroidRaySpheres.Add(AddAsteroidRaySphere(Asteroid));
+
+		if (UAFPS_AsteroidSpinComponent* Spin = GetAsteroidSpin())
+		{
+			Spin->AddAsteroid(Asteroid);
+		}
+	}
+}
+
+void AAFPS_GameMode::UnregisterLiveAsteroid(AAFPS_Asteroid* Asteroid)
+{
+	if (Asteroid == nullptr)
+	{
+		return;
+	}
+
+	const int32 Index = Asteroid->GetLiveAsteroidIndex();
+	if (LiveAsteroids.IsValidIndex(Index) && LiveAsteroids[Index] == Asteroid)
+	{
+		RemoveAsteroidRaySphere(LiveAsteroidRaySpheres[Index]);
+
+		LiveAsteroids.RemoveAtSwap(Index, 1, false);
+		LiveAsteroidRaySpheres.RemoveAtSwap(Index, 1, false);
+		if (UAFPS_AsteroidSpinComponent* Spin = GetAsteroidSpin())
+		{
+			Spin->RemoveAsteroidAtSwap(Index);
+		}
+		if (LiveAsteroids.IsValidIndex(Index) && LiveAsteroids[Index])
+		{
+			LiveAsteroids[Index]->SetLiveAsteroidIndex(Index);  // last asteroid is moved to removed one place
+		}
+	}
+	Asteroid->SetLiveAsteroidIndex(INDEX_NONE);
+
+	// asteroid may be destroyed without kill, spawner have to forget it too
+	if (AsteroidSpawner)
+	{
+		AsteroidSpawner->RemoveSpawnedAsteroid(Asteroid);
+	}
+}
+
+void AAFPS_GameMode::BuildAsteroidRayCaster()
+{
+	SCOPE_CYCLE_COUNTER(STAT_AsteroidRayCasterBuild);
+
+	// rebuilt from scratch, so removed spheres are dropped and sphere indices stay dense
+	AsteroidRayCaster.Reset();
+	AsteroidRayTargets.Reset();
+
+	LiveAsteroidRaySpheres.Reset(LiveAsteroids.Num());
+	for (AAFPS_Asteroid* Asteroid : LiveAsteroids)
+	{
+		LiveAsteroidRaySpheres.Add(AddAsteroidRaySphere(Asteroid));
+	}
+
+	FieldInstanceRaySpheres.Reset();
+	AAFPS_AsteroidField* AsteroidField = AsteroidSpawner ? AsteroidSpawner->GetAsteroidField() : nullptr;
+	if (AsteroidField)
+	{
+		FieldInstanceRaySpheres.Init(INDEX_NONE, AsteroidField->GetInstanceNum());
+		for (int32 InstanceIndex = 0, InstanceNum = AsteroidField->GetInstanceNum(); InstanceIndex != InstanceNum; ++InstanceIndex)
+		{
+			if (AsteroidField->IsInstanceAlive(InstanceIndex))
+			{
+				FieldInstanceRaySpheres[InstanceIndex] = AddFieldInstanceRaySphere(AsteroidField, InstanceIndex);
+			}
+		}
+	}
+
+	AsteroidRayCaster.Build();
+	bAsteroidRayCasterDirty = false;
+	AsteroidRayCasterBuildFrame = GFrameCounter;
+
+	SET_MEMORY_STAT(STAT_AsteroidRayCasterMemory, AsteroidRayCaster.GetAllocatedSize());
+}
+
+int32 AAFPS_GameMode::AddAsteroidRaySphere(AAFPS_Asteroid* Asteroid)
+{
+	UStaticMeshComponent* MeshComp = Asteroid ? Asteroid->GetMesh() : nullptr;
+	if (MeshComp == nullptr || !MeshComp->IsCollisionEnabled())
+	{
+		return INDEX_NONE;
+	}
+
+	// asteroids are locked in translation, so rotation independent sphere around actor location stays valid while asteroid spins
+	const FVector Location = Asteroid->GetActorLocation();
+	const FBoxSphereBounds& Bounds = MeshComp->Bounds;
+	AsteroidRayTargets.Emplace(MeshComp, INDEX_NONE);
+	bAsteroidRayCasterDirty = true;
+
+	return AsteroidRayCaster.AddSphere(Location, Bounds.SphereRadius + FVector::Dist(Bounds.Origin, Location));
+}
+
+int32 AAFPS_GameMode::AddFieldInstanceRaySphere(AAFPS_AsteroidField* Field, int32 InstanceIndex)
+{
+	AsteroidRayTargets.Emplace(Field->GetInstancesComp(), InstanceIndex);
+	bAsteroidRayCasterDirty = true;
+
+	return AsteroidRayCaster.AddSphere(Field->GetInstanceLocation(InstanceIndex), Field->GetInstanceRadius(InstanceIndex));
+}
+
+void AAFPS_GameMode::RemoveAsteroidRaySphere(int32 SphereIndex)
+{
+	if (SphereIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	AsteroidRayCaster.RemoveSphere(SphereIndex);
+	AsteroidRayTargets[SphereIndex] = TPair<UPrimitiveComponent*, int32>(nullptr, INDEX_NONE);
+
+	// removed spheres cost only slot tests, hierarchy is rebuilt when most of them are removed
+	if (AsteroidRayCaster.GetRemovedNum() * 2 > AsteroidRayCaster.Num())
+	{
+		bAsteroidRayCasterDirty = true;
+	}
+}
+
+void AAFPS_GameMode::RegisterAsteroidFieldInstance(AAFPS_AsteroidField* Field, int32 InstanceIndex)
+{
+	// only asteroid spawner field is traced
+	if (Field == nullptr || AsteroidSpawner == nullptr || AsteroidSpawner->GetAsteroidField() != Field)
+	{
+		return;
+	}
+
+	while (FieldInstanceRaySpheres.Num() <= InstanceIndex)
+	{
+		FieldInstanceRaySpheres.Add(INDEX_NONE);
+	}
+
+	RemoveAsteroidRaySphere(FieldInstanceRaySpheres[InstanceIndex]);
+	FieldInstanceRaySpheres[InstanceIndex] = AddFieldInstanceRaySphere(Field, InstanceIndex);
+}
+
+void AAFPS_GameMode::UnregisterAsteroidFieldInstance(AAFPS_AsteroidField* Field, int32 InstanceIndex)
+{
+	if (Field == nullptr || AsteroidSpawner == nullptr || AsteroidSpawner->GetAsteroidField() != Field
+		|| !FieldInstanceRaySpheres.IsValidIndex(InstanceIndex))
+	{
+		return;
+	}
+
+	RemoveAsteroidRaySphere(FieldInstanceRaySpheres[InstanceIndex]);
+	FieldInstanceRaySpheres[InstanceIndex] = INDEX_NONE;
+}
+
+bool AAFPS_GameMode::RaycastAsteroids(const FVector& Start, const FVector& Direction, float Range, FHitResult& OutHit)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AsteroidRaycast);
+
+	// spheres added since build are tested linearly meanwhile, so several sets changes in frame cost single rebuild
+	if (bAsteroidRayCasterDirty && AsteroidRayCasterBuildFrame != GFrameCounter)
+	{
+		BuildAsteroidRayCaster();
+	}
+
+	OutHit = FHitResult();
+
+	const int32 HitNum = AsteroidRayCaster.Raycast(Start, Direction, Range, AsteroidRayHits);
+
+	static const FCollisionQueryParams RefineParams(SCENE_QUERY_STAT(AsteroidRaycastRefine), true);
+
+	const FVector End = Start + Direction * Range;
+
+	// ray can pass bounding sphere without hitting rock and rock in farther entered sphere can be hit first,
+	// so candidates are refined until next sphere entry is behind nearest hit
+	bool bHit = false;
+	FHitResult CandidateHit;
+	for (int32 It = 0; It != HitNum && (!bHit || AsteroidRayHits[It].Distance < OutHit.Distance); ++It)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_AsteroidRaycastRefine);
+
+		const TPair<UPrimitiveComponent*, int32>& Target = AsteroidRayTargets[AsteroidRayHits[It].SphereIndex];
+
+		if (Target.Key == nullptr)
+		{
+			continue;  // removed sphere
+		}
+
+		bool bCandidateHit = false;
+		if (Target.Value == INDEX_NONE)
+		{
+			bCandidateHit = Target.Key->LineTraceComponent(CandidateHit, Start, End, RefineParams);
+		}
+		else
+		{
+			// instanced mesh has body per instance
+			UInstancedStaticMeshComponent* InstancesComp = static_cast<UInstancedStaticMeshComponent*>(Target.Key);
+			const FBodyInstance* InstanceBody = InstancesComp->InstanceBodies.IsValidIndex(Target.Value) ? InstancesComp->InstanceBodies[Target.Value] : nullptr;
+			if (InstanceBody && InstanceBody->LineTrace(CandidateHit, Start, End, true))
+			{
+				CandidateHit.Component = InstancesComp;
+				CandidateHit.Actor = InstancesComp->GetOwner();
+				CandidateHit.Item = Target.Value;
+				bCandidateHit = true;
+			}
+		}
+
+		if (bCandidateHit && (!bHit || CandidateHit.Distance < OutHit.Distance))
+		{
+			OutHit = CandidateHit;
+			bHit = true;
+		}
+	}
+
+	if (bHit)
+	{
+		OutHit.TraceStart = Start;
+		OutHit.TraceEnd = End;
+	}
+
+	return bHit;
+}
+
+void AAFPS_GameMode::OnAsteroidKilled(const FKillEvent& KillEvent)
+{
+	++KilledAsteroidNum;
+
+	NotifyKilledAsteroidNumChanged.Broadcast();
 }
 
 void AAFPS_GameMode::OnAsteroidSpawned(AAFPS_Asteroid* Asteroid)
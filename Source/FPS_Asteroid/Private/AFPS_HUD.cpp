@@ -2,11 +2,96 @@
 
 
 #include "AFPS_HUD.h"
+#include "AFPS_HUDBenchmarkListener.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Kismet/GameplayStatics.h"
 
 #include <Character/AFPS_Character.h>
 #include <Character/AFPS_Weapon.h>
 #include <AFPS_GameMode.h>
 #include <AFPS_AsteroidSpawner.h>
+#include <AFPS_AsteroidField.h>
+#include <AFPS_Asteroid.h>
+#include <AFPS_ScopeStats.h>
+
+AFPS_DECLARE_SCOPE_STAT("HUD Draw", HUDDraw);
+AFPS_DECLARE_SCOPE_STAT("HUD Getters", HUDGetters);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("HUD View Model Notifications"), STAT_HUDViewModelNotifications, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_COUNTER_STAT(TEXT("HUD View Model Broadcasts"), STAT_HUDViewModelBroadcasts, STATGROUP_FPSAsteroid);
+DECLARE_CYCLE_STAT(TEXT("HUD Threat Positions Gather"), STAT_HUDThreatPositionsGather, STATGROUP_FPSAsteroid);
+
+static FAutoConsoleCommandWithWorldAndArgs HUDBenchmarkViewModelCmd(
+	TEXT("AFPS.HUD.BenchmarkViewModel"),
+	TEXT("Time N frames of widget getter bindings (5 HUD getters called through reflection like UMG property bindings) against N view model change broadcasts to one subscriber. Usage: AFPS.HUD.BenchmarkViewModel [Frames]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		APlayerController* PC = World ? World->GetFirstPlayerController() : nullptr;
+		AAFPS_HUD* HUD = PC ? Cast<AAFPS_HUD>(PC->GetHUD()) : nullptr;
+		if (HUD == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("[HUD] BenchmarkViewModel: no AAFPS_HUD"));
+			return;
+		}
+
+		const int32 FrameNum = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 10000;
+
+		// before: every binding is evaluated every frame, values changed or not
+		const FName GetterNames[] = {
+			GET_FUNCTION_NAME_CHECKED(AAFPS_HUD, GetAsteroidSpawnWaveCount),
+			GET_FUNCTION_NAME_CHECKED(AAFPS_HUD, GetAsteroidToKillForNextWave),
+			GET_FUNCTION_NAME_CHECKED(AAFPS_HUD, GetAliveSpawnedAsteroidNum),
+			GET_FUNCTION_NAME_CHECKED(AAFPS_HUD, GetKilledAsteroidNum),
+			GET_FUNCTION_NAME_CHECKED(AAFPS_HUD, GetCharacterWeaponEnergyLevelAlpha),
+		};
+		UFunction* Getters[UE_ARRAY_COUNT(GetterNames)];
+		int32 ParmsSize = 0;
+		for (int32 It = 0; It != UE_ARRAY_COUNT(GetterNames); ++It)
+		{
+			Getters[It] = HUD->FindFunctionChecked(GetterNames[It]);
+			ParmsSize = FMath::Max<int32>(ParmsSize, Getters[It]->ParmsSize);
+		}
+
+		// getters have only POD return value
+		TArray<uint8> Parms;
+		Parms.SetNumZeroed(ParmsSize);
+
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Frame = 0; Frame != FrameNum; ++Frame)
+		{
+			for (UFunction* Getter : Getters)
+			{
+				HUD->ProcessEvent(Getter, Parms.GetData());
+			}
+		}
+		const double GettersMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		// after: one broadcast per frame with changed view model, worst case every frame changes
+		UAFPS_HUDBenchmarkListener* Listener = NewObject<UAFPS_HUDBenchmarkListener>();
+		FOnHUDViewModelChanged NotifyViewModelChanged;
+		NotifyViewModelChanged.AddDynamic(Listener, &UAFPS_HUDBenchmarkListener::OnViewModelChanged);
+
+		const FHUDViewModel ViewModel = HUD->GetViewModel();
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Frame = 0; Frame != FrameNum; ++Frame)
+		{
+			NotifyViewModelChanged.Broadcast(ViewModel);
+		}
+		const double BroadcastsMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		UE_LOG(LogTemp, Display, TEXT("[HUD] %d frames: getter bindings %.3f ms (%.2f us per frame), view model broadcasts %.3f ms (%.2f us per broadcast), broadcasts are sent only on frames with changes"),
+			FrameNum, GettersMs, GettersMs * 1000.0 / FrameNum, BroadcastsMs, BroadcastsMs * 1000.0 / FrameNum);
+
+		Listener->MarkPendingKill();
+	})
+);
+
+void UAFPS_HUDBenchmarkListener::OnViewModelChanged(const FHUDViewModel& ViewModel)
+{
+	ValueSum += ViewModel.WaveCount + ViewModel.AsteroidToKillForNextWave + ViewModel.AliveSpawnedAsteroidNum
+		+ ViewModel.KilledAsteroidNum + ViewModel.WeaponEnergyLevelAlpha;
+}
 
 AAFPS_HUD::AAFPS_HUD()
 {
@@ -15,6 +100,20 @@ AAFPS_HUD::AAFPS_HUD()
 	{
 		CrosshairTexture = CrosshairTextureObjFinder.Object;
 	}
+
+	// tick only polls view model sources, disabled once spawner and weapon are bound, notifications rebind them
+	PrimaryActorTick.bCanEverTick = true;
+
+	// threat indicators
+	ThreatIndicatorTexture = nullptr;
+	MaxThreatIndicators = 8;
+	ThreatIndicatorSize = 24.f;
+	ThreatIndicatorEdgeMargin = 32.f;
+	ThreatIndicatorNearColor = FLinearColor::Red;
+	ThreatIndicatorFarColor = FLinearColor::Yellow;
+	ThreatIndicatorFarDistance = 20000.f;
+
+	bViewModelDirty = true;
 }
 
 void AAFPS_HUD::BeginPlay()
@@ -28,90 +127,286 @@ void AAFPS_HUD::BeginPlay()
 
 	// get gamemode
 	GM = Cast<AAFPS_GameMode>(GetWorld()->GetAuthGameMode<AAFPS_GameMode>());
+	if (GM)
+	{
+		GM->NotifyKilledAsteroidNumChanged.AddUObject(this, &AAFPS_HUD::OnKilledAsteroidNumChanged);
+		GM->NotifyAsteroidSpawnerCreated.AddUObject(this, &AAFPS_HUD::BindViewModelSources);
+		OnKilledAsteroidNumChanged();
+	}
+
+	BindViewModelSources();
 }
 
-void AAFPS_HUD::DrawHUD()
+void AAFPS_HUD::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	if (Canvas)
+	if (GM)
 	{
-		float CanvasCenterX, CanvasCenterY;
-		Canvas->GetCenter(CanvasCenterX, CanvasCenterY);
-		
-		Canvas->DrawIcon(CrosshairIcon, CanvasCenterX - CrosshairIcon.UL * 0.5f, CanvasCenterY - CrosshairIcon.VL * 0.5f, 1.f);
+		GM->NotifyKilledAsteroidNumChanged.RemoveAll(this);
+		GM->NotifyAsteroidSpawnerCreated.RemoveAll(this);
+	}
+	if (IsValid(Character))
+	{
+		Character->NotifyWeaponChanged.RemoveAll(this);
+	}
+	if (BoundSpawner.IsValid())
+	{
+		BoundSpawner->NotifyWaveStateChanged.RemoveAll(this);
+	}
+	if (BoundWeapon.IsValid())
+	{
+		BoundWeapon->NotifyEnergyChanged.RemoveAll(this);
 	}
 
-	Super::DrawHUD();
+	Super::EndPlay(EndPlayReason);
 }
 
-int32 AAFPS_HUD::GetAsteroidSpawnWaveCount()
+void AAFPS_HUD::Tick(float DeltaSeconds)
 {
-	if (GM)
+	Super::Tick(DeltaSeconds);
+
+	BindViewModelSources();
+}
+
+void AAFPS_HUD::BindViewModelSources()
+{
+	// spawner is created by game mode after actors begin play
+	if (GM && !BoundSpawner.IsValid())
 	{
-		if (auto AsteroidSpawner = GM->GetAsteroidSpawner())
+		if (AAFPS_AsteroidSpawner* AsteroidSpawner = GM->GetAsteroidSpawner())
 		{
-			return AsteroidSpawner->GetWaveCount();
+			BoundSpawner = AsteroidSpawner;
+			AsteroidSpawner->NotifyWaveStateChanged.AddUObject(this, &AAFPS_HUD::OnWaveStateChanged);
+			OnWaveStateChanged();
 		}
 	}
 
-	return 0;
-}
+	// character and weapon can be changed on possession or weapon respawn, character notifies both,
+	// unpossessed pawn is still controller pawn while it's notifying, but has no controller already
+	APawn* OwningPawn = GetOwningPawn();
+	if (OwningPawn && OwningPawn->GetController() != GetOwningPlayerController())
+	{
+		OwningPawn = nullptr;
+	}
 
-int32 AAFPS_HUD::GetAsteroidToKillForNextWave()
-{
-	if (GM)
+	if (OwningPawn != Character)
 	{
-		if (auto AsteroidSpawner = GM->GetAsteroidSpawner())
+		if (IsValid(Character))
 		{
-			return AsteroidSpawner->GetAsteroidToKillForNextWave();
+			Character->NotifyWeaponChanged.RemoveAll(this);
 		}
-	}
 
-	return 0;
-}
+		Character = Cast<AAFPS_Character>(OwningPawn);
+		if (Character)
+		{
+			Character->NotifyWeaponChanged.AddUObject(this, &AAFPS_HUD::BindViewModelSources);
+		}
+	}
 
-int32 AAFPS_HUD::GetAliveSpawnedAsteroidNum()
-{
-	if (GM)
+	AAFPS_Weapon* Weapon = Character ? Character->GetWeaponInHands() : nullptr;
+	if (Weapon != BoundWeapon.Get())
 	{
-		if (auto AsteroidSpawner = GM->GetAsteroidSpawner())
+		if (BoundWeapon.IsValid())
 		{
-			auto& SpawnedAsteroids = AsteroidSpawner->GetAliveSpawnedAsteroids();
+			BoundWeapon->NotifyEnergyChanged.RemoveAll(this);
+		}
+
+		BoundWeapon = Weapon;
 
-			return SpawnedAsteroids.Num();
+		if (Weapon)
+		{
+			Weapon->NotifyEnergyChanged.AddUObject(this, &AAFPS_HUD::OnWeaponEnergyChanged);
 		}
+		OnWeaponEnergyChanged(Weapon ? Weapon->GetEnergyLevelAlpha() : 0.f);
 	}
 
-	return 0;
+	// poll only while some source is missing, e.g. pawn is not possessed yet
+	SetActorTickEnabled(!BoundSpawner.IsValid() || !BoundWeapon.IsValid());
 }
 
-int32 AAFPS_HUD::GetKilledAsteroidNum()
+void AAFPS_HUD::OnWaveStateChanged()
 {
-	if (GM)
+	INC_DWORD_STAT(STAT_HUDViewModelNotifications);
+
+	if (AAFPS_AsteroidSpawner* AsteroidSpawner = BoundSpawner.Get())
 	{
-		return GM->GetKilledAsteroidNum();
+		SetViewModelValue(ViewModel.WaveCount, AsteroidSpawner->GetWaveCount());
+		SetViewModelValue(ViewModel.AsteroidToKillForNextWave, AsteroidSpawner->GetAsteroidToKillForNextWave());
+		SetViewModelValue(ViewModel.AliveSpawnedAsteroidNum, AsteroidSpawner->GetAliveSpawnedAsteroidNum());
 	}
+}
 
-	return 0;
+void AAFPS_HUD::OnKilledAsteroidNumChanged()
+{
+	INC_DWORD_STAT(STAT_HUDViewModelNotifications);
+
+	SetViewModelValue(ViewModel.KilledAsteroidNum, GM->GetKilledAsteroidNum());
 }
 
-float AAFPS_HUD::GetCharacterWeaponEnergyLevelAlpha()
+void AAFPS_HUD::OnWeaponEnergyChanged(float EnergyLevelAlpha)
 {
-	if (Character)
+	INC_DWORD_STAT(STAT_HUDViewModelNotifications);
+
+	SetViewModelValue(ViewModel.WeaponEnergyLevelAlpha, EnergyLevelAlpha);
+}
+
+void AAFPS_HUD::DrawHUD()
+{
+	AFPS_SCOPE_STAT(HUDDraw);
+
+	DrawBatch.Reset();
+
+	if (Canvas)
+	{
+		float CanvasCenterX, CanvasCenterY;
+		Canvas->GetCenter(CanvasCenterX, CanvasCenterY);
+		
+		DrawBatch.AddIcon(CrosshairIcon, FVector2D(CanvasCenterX, CanvasCenterY), 1.f, FLinearColor::White);
+
+		DrawThreatIndicators();
+	}
+
+	#if WITH_EDITOR
+	DrawDebugTexts();
+	#endif  // WITH_EDITOR
+
+	// single canvas item per texture, counters are updated without canvas too
+	DrawBatch.Flush(Canvas ? Canvas->Canvas : nullptr);
+
+	// all changes of frame are sent to UI at once
+	if (bViewModelDirty)
+	{
+		bViewModelDirty = false;
+		NotifyViewModelChanged.Broadcast(ViewModel);
+
+		INC_DWORD_STAT(STAT_HUDViewModelBroadcasts);
+	}
+
+	Super::DrawHUD();
+}
+
+void AAFPS_HUD::DrawThreatIndicators()
+{
+	AAFPS_AsteroidSpawner* AsteroidSpawner = BoundSpawner.Get();
+	if (MaxThreatIndicators <= 0 || AsteroidSpawner == nullptr || PlayerOwner == nullptr || PlayerOwner->PlayerCameraManager == nullptr)
 	{
-		if (auto Weapon = Character->GetWeaponInHands())
+		return;
+	}
+
+	// actor locations are read on game thread, projection and nearest selection run in parallel
+	{
+		SCOPE_CYCLE_COUNTER(STAT_HUDThreatPositionsGather);
+
+		ThreatPositions.Reset();
+		for (const AAFPS_Asteroid* Asteroid : AsteroidSpawner->GetAliveSpawnedAsteroids())
 		{
-			return Weapon->GetEnergyLevelAlpha();
+			ThreatPositions.Add(Asteroid->GetActorLocation());
+		}
+
+		if (const AAFPS_AsteroidField* Field = AsteroidSpawner->GetAsteroidField())
+		{
+			for (int32 It = 0, Num = Field->GetInstanceNum(); It != Num; ++It)
+			{
+				if (Field->IsInstanceAlive(It))
+				{
+					ThreatPositions.Add(Field->GetInstanceLocation(It));
+				}
+			}
 		}
 	}
-	else
+
+	FMinimalViewInfo ViewInfo = PlayerOwner->PlayerCameraManager->GetCameraCachePOV();
+	ViewInfo.AspectRatio = Canvas->ClipX / FMath::Max(Canvas->ClipY, 1.f);
+	ViewInfo.bConstrainAspectRatio = true;
+
+	FMatrix ViewMatrix, ProjectionMatrix, ViewProjectionMatrix;
+	UGameplayStatics::GetViewProjectionMatrix(ViewInfo, ViewMatrix, ProjectionMatrix, ViewProjectionMatrix);
+
+	ThreatIndicators.Update(ViewInfo.Location, ViewProjectionMatrix, ThreatPositions, MaxThreatIndicators);
+
+	// indicators are placed on screen edge in asteroid direction
+	const FVector2D ScreenCenter(Canvas->ClipX * 0.5f, Canvas->ClipY * 0.5f);
+	const FVector2D EdgeExtent = FVector2D::Max(ScreenCenter - FVector2D(ThreatIndicatorEdgeMargin, ThreatIndicatorEdgeMargin), FVector2D::ZeroVector);
+
+	for (const FThreatIndicator& Indicator : ThreatIndicators.GetIndicators())
 	{
-		// get character
-		Character = Cast<AAFPS_Character>(GetOwningPawn());
-		if (Character)
+		const float EdgeScaleX = Indicator.Direction.X != 0.f ? EdgeExtent.X / FMath::Abs(Indicator.Direction.X) : BIG_NUMBER;
+		const float EdgeScaleY = Indicator.Direction.Y != 0.f ? EdgeExtent.Y / FMath::Abs(Indicator.Direction.Y) : BIG_NUMBER;
+		const FVector2D Position = ScreenCenter + Indicator.Direction * FMath::Min(EdgeScaleX, EdgeScaleY);
+
+		const float RotationDeg = FMath::RadiansToDegrees(FMath::Atan2(Indicator.Direction.Y, Indicator.Direction.X));
+		const FLinearColor Color = FMath::Lerp(ThreatIndicatorNearColor, ThreatIndicatorFarColor,
+			FMath::Clamp(Indicator.Distance / FMath::Max(ThreatIndicatorFarDistance, 1.f), 0.f, 1.f));
+
+		DrawBatch.AddQuad(ThreatIndicatorTexture, Position, FVector2D(ThreatIndicatorSize, ThreatIndicatorSize),
+			FVector2D::ZeroVector, FVector2D::UnitVector, Color, RotationDeg);
+	}
+}
+
+int32 AAFPS_HUD::GetAsteroidSpawnWaveCount()
+{
+	AFPS_SCOPE_STAT(HUDGetters);
+
+	return ViewModel.WaveCount;
+}
+
+int32 AAFPS_HUD::GetAsteroidToKillForNextWave()
+{
+	AFPS_SCOPE_STAT(HUDGetters);
+
+	return ViewModel.AsteroidToKillForNextWave;
+}
+
+int32 AAFPS_HUD::GetAliveSpawnedAsteroidNum()
+{
+	AFPS_SCOPE_STAT(HUDGetters);
+
+	return ViewModel.AliveSpawnedAsteroidNum;
+}
+
+int32 AAFPS_HUD::GetKilledAsteroidNum()
+{
+	AFPS_SCOPE_STAT(HUDGetters);
+
+	return ViewModel.KilledAsteroidNum;
+}
+
+float AAFPS_HUD::GetCharacterWeaponEnergyLevelAlpha()
+{
+	AFPS_SCOPE_STAT(HUDGetters);
+
+	return ViewModel.WeaponEnergyLevelAlpha;
+}
+
+#if WITH_EDITOR
+void AAFPS_HUD::AddDebugText(const AActor* Owner, const FDebugTextBuilder& Text, const FVector& Location, const FLinearColor& Color)
+{
+	DebugTexts.Add({ Owner, &Text, Location, Color });
+}
+
+void AAFPS_HUD::DrawDebugTexts()
+{
+	if (Canvas && GEngine)
+	{
+		for (const FDebugTextOverlay& DebugText : DebugTexts)
 		{
-			GetCharacterWeaponEnergyLevelAlpha();
+			// owner destroyed after adding text frees builder
+			if (!DebugText.Owner.IsValid())
+			{
+				continue;
+			}
+
+			const FVector ScreenLocation = Canvas->Project(DebugText.Location);
+			if (ScreenLocation.Z <= 0.f)
+			{
+				continue;  // behind view
+			}
+
+			FCanvasTextItem TextItem(FVector2D(ScreenLocation), DebugText.Text->GetDisplayText(), GEngine->GetSmallFont(), DebugText.Color);
+			TextItem.EnableShadow(FLinearColor::Black);
+			Canvas->DrawItem(TextItem);
 		}
 	}
 
-	return 0.f;
-}
\ No newline at end of file
+	DebugTexts.Reset();
+}
+#endif  // WITH_EDITOR
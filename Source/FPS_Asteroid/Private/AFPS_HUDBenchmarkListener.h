@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "AFPS_HUD.h"
+#include "AFPS_HUDBenchmarkListener.generated.h"
+
+/**
+ * View model subscriber of AFPS.HUD.BenchmarkViewModel, reads every value like widget bindings did
+ */
+UCLASS(Transient)
+class UAFPS_HUDBenchmarkListener : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Sum of read values, keeps reads from being optimized out */
+	float ValueSum = 0.f;
+
+	UFUNCTION()
+	void OnViewModelChanged(const FHUDViewModel& ViewModel);
+};
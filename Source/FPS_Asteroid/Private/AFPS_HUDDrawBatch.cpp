@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AFPS_HUDDrawBatch.h"
+
+#include "CanvasTypes.h"
+#include "Engine/Canvas.h"
+#include "Engine/Texture.h"
+
+#include <FPS_Asteroid/FPS_Asteroid.h>
+
+DECLARE_CYCLE_STAT(TEXT("HUD Draw Batch Flush"), STAT_HUDDrawBatchFlush, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_COUNTER_STAT(TEXT("HUD Draw Items"), STAT_HUDDrawItems, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_COUNTER_STAT(TEXT("HUD Draw Quads"), STAT_HUDDrawQuads, STATGROUP_FPSAsteroid);
+
+void FHUDDrawBatch::Reset()
+{
+	for (FTextureBatch& Batch : Batches)
+	{
+		Batch.Item.TriangleList.Reset();
+	}
+
+	QuadNum = 0;
+}
+
+FCanvasTriangleItem& FHUDDrawBatch::GetTextureItem(UTexture* Texture)
+{
+	for (FTextureBatch& Batch : Batches)
+	{
+		if (Batch.Texture == Texture)
+		{
+			return Batch.Item;
+		}
+	}
+
+	const FTexture* TextureResource = Texture && Texture->Resource ? Texture->Resource : GWhiteTexture;
+
+	FTextureBatch& Batch = Batches.Add_GetRef({ Texture, FCanvasTriangleItem(FVector2D::ZeroVector, FVector2D::ZeroVector, FVector2D::ZeroVector, TextureResource) });
+	Batch.Item.TriangleList.Reset();
+	Batch.Item.BlendMode = SE_BLEND_Translucent;
+
+	return Batch.Item;
+}
+
+void FHUDDrawBatch::AddQuad(UTexture* Texture, const FVector2D& Center, const FVector2D& Size, const FVector2D& UV0, const FVector2D& UV1,
+	const FLinearColor& Color, float RotationDeg)
+{
+	FCanvasTriangleItem& Item = GetTextureItem(Texture);
+
+	// corners clockwise from top left
+	const FVector2D HalfSize = Size * 0.5f;
+	FVector2D Corners[4] = { { -HalfSize.X, -HalfSize.Y }, { HalfSize.X, -HalfSize.Y }, { HalfSize.X, HalfSize.Y }, { -HalfSize.X, HalfSize.Y } };
+	const FVector2D UVs[4] = { { UV0.X, UV0.Y }, { UV1.X, UV0.Y }, { UV1.X, UV1.Y }, { UV0.X, UV1.Y } };
+
+	if (RotationDeg != 0.f)
+	{
+		float Sin, Cos;
+		FMath::SinCos(&Sin, &Cos, FMath::DegreesToRadians(RotationDeg));
+		for (FVector2D& Corner : Corners)
+		{
+			Corner = FVector2D(Corner.X * Cos - Corner.Y * Sin, Corner.X * Sin + Corner.Y * Cos);
+		}
+	}
+
+	for (int32 TriIt = 0; TriIt != 2; ++TriIt)
+	{
+		// 0-1-2 and 0-2-3
+		FCanvasUVTri& Tri = Item.TriangleList.AddDefaulted_GetRef();
+		const int32 B = TriIt + 1;
+		const int32 C = TriIt + 2;
+
+		Tri.V0_Pos = Center + Corners[0];
+		Tri.V1_Pos = Center + Corners[B];
+		Tri.V2_Pos = Center + Corners[C];
+		Tri.V0_UV = UVs[0];
+		Tri.V1_UV = UVs[B];
+		Tri.V2_UV = UVs[C];
+		Tri.V0_Color = Color;
+		Tri.V1_Color = Color;
+		Tri.V2_Color = Color;
+	}
+
+	++QuadNum;
+}
+
+void FHUDDrawBatch::AddIcon(const FCanvasIcon& Icon, const FVector2D& Center, float Scale, const FLinearColor& Color, float RotationDeg)
+{
+	if (Icon.Texture == nullptr)
+	{
+		return;
+	}
+
+	const float TextureSizeX = Icon.Texture->GetSurfaceWidth();
+	const float TextureSizeY = Icon.Texture->GetSurfaceHeight();
+	if (TextureSizeX <= 0.f || TextureSizeY <= 0.f)
+	{
+		return;
+	}
+
+	// same UVs as UCanvas::DrawIcon
+	const FVector2D UV0(Icon.U / TextureSizeX, Icon.V / TextureSizeY);
+	const FVector2D UV1((Icon.U + Icon.UL) / TextureSizeX, (Icon.V + Icon.VL) / TextureSizeY);
+
+	AddQuad(Icon.Texture, Center, FVector2D(FMath::Abs(Icon.UL), FMath::Abs(Icon.VL)) * Scale, UV0, UV1, Color, RotationDeg);
+}
+
+void FHUDDrawBatch::Flush(FCanvas* Canvas)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HUDDrawBatchFlush);
+
+	DrawItemNum = 0;
+
+	for (FTextureBatch& Batch : Batches)
+	{
+		if (Batch.Item.TriangleList.Num() == 0)
+		{
+			continue;
+		}
+
+		// texture resource may be recreated, e.g. on streaming
+		if (Batch.Texture && Batch.Texture->Resource)
+		{
+			Batch.Item.Texture = Batch.Texture->Resource;
+		}
+
+		if (Canvas)
+		{
+			Canvas->DrawItem(Batch.Item);
+		}
+		++DrawItemNum;
+	}
+
+	SET_DWORD_STAT(STAT_HUDDrawItems, DrawItemNum);
+	SET_DWORD_STAT(STAT_HUDDrawQuads, QuadNum);
+}
@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "AFPS_KillEventBus.h"
+#include "AFPS_KillEventBenchmarkListener.generated.h"
+
+/**
+ * Kill subscriber of AFPS.KillEventBus.Benchmark, does same work on dynamic and native path: victim cast and kill count
+ */
+UCLASS(Transient)
+class UAFPS_KillEventBenchmarkListener : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	int32 AsteroidKillNum = 0;
+
+	/** Old NotifyActorKilled subscriber, classifies victim itself */
+	UFUNCTION()
+	void OnActorKilled(AActor* Victim, AActor* Killer, AController* KillerController);
+
+	/** Kill event bus asteroid subscriber, victim is already classified */
+	void OnAsteroidKilled(const FKillEvent& KillEvent);
+};
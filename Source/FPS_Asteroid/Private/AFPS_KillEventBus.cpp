@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AFPS_KillEventBus.h"
+#include "AFPS_KillEventBenchmarkListener.h"
+
+#include "AFPS_Asteroid.h"
+#include "AFPS_AsteroidField.h"
+#include "AFPS_GameMode.h"
+
+#include <FPS_Asteroid/FPS_Asteroid.h>
+
+DECLARE_CYCLE_STAT(TEXT("Kill Event Broadcast"), STAT_KillEventBroadcast, STATGROUP_FPSAsteroid);
+
+static FAutoConsoleCommandWithWorldAndArgs KillEventBusBenchmarkCmd(
+	TEXT("AFPS.KillEventBus.Benchmark"),
+	TEXT("Time 10k asteroid kills per frame through dynamic NotifyActorKilled and native kill event bus, two subscribers each. Usage: AFPS.KillEventBus.Benchmark [Frames] [KillsPerFrame]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (World == nullptr)
+		{
+			return;
+		}
+
+		const int32 FrameNum = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 10;
+		const int32 KillNum = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 10000;
+
+		// real asteroid victim, subscribers cast it like game mode and spawner did
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		AAFPS_Asteroid* Victim = World->SpawnActor<AAFPS_Asteroid>(AAFPS_Asteroid::StaticClass(), FTransform(FVector(0.f, 0.f, -1'000'000'00.f)), SpawnParams);
+		if (Victim == nullptr)
+		{
+			return;
+		}
+
+		UAFPS_KillEventBenchmarkListener* Listeners[2] = { NewObject<UAFPS_KillEventBenchmarkListener>(), NewObject<UAFPS_KillEventBenchmarkListener>() };
+
+		FOnActorKilledSignature NotifyActorKilled;
+		FKillEventBus KillEventBus;
+		for (UAFPS_KillEventBenchmarkListener* Listener : Listeners)
+		{
+			NotifyActorKilled.AddDynamic(Listener, &UAFPS_KillEventBenchmarkListener::OnActorKilled);
+			KillEventBus.OnKill(EKillVictimCategory::Asteroid).AddUObject(Listener, &UAFPS_KillEventBenchmarkListener::OnAsteroidKilled);
+		}
+
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 It = 0, Num = FrameNum * KillNum; It != Num; ++It)
+		{
+			NotifyActorKilled.Broadcast(Victim, nullptr, nullptr);
+		}
+		const double DynamicMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / FrameNum;
+		const int32 DynamicKillNum = Listeners[0]->AsteroidKillNum;
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 It = 0, Num = FrameNum * KillNum; It != Num; ++It)
+		{
+			FKillEvent KillEvent;
+			KillEvent.Victim = Victim;
+			KillEvent.Category = EKillVictimCategory::Asteroid;
+			KillEventBus.Broadcast(KillEvent);
+		}
+		const double NativeMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / FrameNum;
+		const int32 NativeKillNum = Listeners[0]->AsteroidKillNum - DynamicKillNum;
+
+		UE_LOG(LogTemp, Display, TEXT("[KillEventBus] %d kills per frame, %d frames: dynamic multicast %.3f ms, native bus %.3f ms per frame (x%.1f), kills %d/%d"),
+			KillNum, FrameNum, DynamicMs, NativeMs, NativeMs > 0.0 ? DynamicMs / NativeMs : 0.0, NativeKillNum, DynamicKillNum);
+
+		Victim->Destroy();
+	})
+);
+
+void UAFPS_KillEventBenchmarkListener::OnActorKilled(AActor* Victim, AActor* Killer, AController* KillerController)
+{
+	if (Cast<AAFPS_Asteroid>(Victim))
+	{
+		++AsteroidKillNum;
+	}
+}
+
+void UAFPS_KillEventBenchmarkListener::OnAsteroidKilled(const FKillEvent& KillEvent)
+{
+	if (KillEvent.GetAsteroid())
+	{
+		++AsteroidKillNum;
+	}
+}
+
+AAFPS_Asteroid* FKillEvent::GetAsteroid() const
+{
+	checkSlow(Category == EKillVictimCategory::Asteroid && !IsFieldInstance());
+	return CastChecked<AAFPS_Asteroid>(Victim);
+}
+
+AAFPS_AsteroidField* FKillEvent::GetAsteroidField() const
+{
+	checkSlow(Category == EKillVictimCategory::Asteroid && IsFieldInstance());
+	return CastChecked<AAFPS_AsteroidField>(Victim);
+}
+
+void FKillEventBus::Broadcast(const FKillEvent& KillEvent)
+{
+	SCOPE_CYCLE_COUNTER(STAT_KillEventBroadcast);
+
+	CategoryKillDelegates[static_cast<uint8>(KillEvent.Category)].Broadcast(KillEvent);
+	AnyKillDelegate.Broadcast(KillEvent);
+}
+
+void FKillEventBus::RemoveAll(const void* InUserObject)
+{
+	for (FOnKillEvent& KillDelegate : CategoryKillDelegates)
+	{
+		KillDelegate.RemoveAll(InUserObject);
+	}
+	AnyKillDelegate.RemoveAll(InUserObject);
+}
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AFPS_ScopeStats.h"
+
+#include "HAL/IConsoleManager.h"
+
+/** Frame counter on last reset, to show calls per frame */
+static uint64 ScopeStatsResetFrame = 0;
+
+FAFPS_ScopeStat::FAFPS_ScopeStat(const TCHAR* InName)
+	: Name(InName)
+{
+	// stats are declared at module load, so list is complete before first dump
+	Next = GetFirst();
+	GetFirst() = this;
+}
+
+FAFPS_ScopeStat*& FAFPS_ScopeStat::GetFirst()
+{
+	static FAFPS_ScopeStat* First = nullptr;
+	return First;
+}
+
+static FAutoConsoleCommandWithOutputDevice ScopeStatsDumpCmd(
+	TEXT("AFPS.Stats.Dump"),
+	TEXT("Print game thread scope stats table collected since last AFPS.Stats.Reset, sorted by total time"),
+	FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar)
+	{
+		TArray<const FAFPS_ScopeStat*> Stats;
+		for (const FAFPS_ScopeStat* Stat = FAFPS_ScopeStat::GetFirst(); Stat; Stat = Stat->Next)
+		{
+			Stats.Add(Stat);
+		}
+		Stats.Sort([](const FAFPS_ScopeStat& A, const FAFPS_ScopeStat& B) { return A.Cycles > B.Cycles; });
+
+		const uint64 FrameNum = FMath::Max<uint64>(GFrameCounter - ScopeStatsResetFrame, 1);
+
+		Ar.Logf(TEXT("AFPS scope stats, %llu frames"), FrameNum);
+		Ar.Logf(TEXT("%-36s %10s %10s %10s %10s %10s"), TEXT("Scope"), TEXT("Calls"), TEXT("Calls/fr"), TEXT("Total ms"), TEXT("Avg us"), TEXT("Max us"));
+
+		for (const FAFPS_ScopeStat* Stat : Stats)
+		{
+			const double TotalMs = FPlatformTime::ToMilliseconds64(Stat->Cycles);
+			Ar.Logf(TEXT("%-36s %10llu %10.2f %10.3f %10.3f %10.3f"), Stat->Name, Stat->Calls, static_cast<double>(Stat->Calls) / FrameNum, TotalMs,
+				Stat->Calls ? TotalMs * 1000.0 / Stat->Calls : 0.0, FPlatformTime::ToMilliseconds64(Stat->MaxCycles) * 1000.0);
+		}
+	})
+);
+
+static FAutoConsoleCommand ScopeStatsResetCmd(
+	TEXT("AFPS.Stats.Reset"),
+	TEXT("Reset game thread scope stats printed by AFPS.Stats.Dump"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		for (FAFPS_ScopeStat* Stat = FAFPS_ScopeStat::GetFirst(); Stat; Stat = Stat->Next)
+		{
+			Stat->Calls = 0;
+			Stat->Cycles = 0;
+			Stat->MaxCycles = 0;
+		}
+
+		ScopeStatsResetFrame = GFrameCounter;
+	})
+);
@@ -0,0 +1,132 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AFPS_ThreatIndicators.h"
+
+#include "Async/ParallelFor.h"
+#include "Kismet/GameplayStatics.h"
+
+#include <FPS_Asteroid/FPS_Asteroid.h>
+
+DECLARE_CYCLE_STAT(TEXT("Threat Indicators Update"), STAT_ThreatIndicatorsUpdate, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Threat Indicators Candidates"), STAT_ThreatIndicatorsCandidates, STATGROUP_FPSAsteroid);
+
+constexpr int32 FAsteroidThreatIndicators::ChunkSize;
+
+static FAutoConsoleCommand ThreatIndicatorsBenchmarkCmd(
+	TEXT("AFPS.HUD.BenchmarkThreatIndicators"),
+	TEXT("Time threat indicators pass over random asteroids around view at 1k and 10k asteroids. Usage: AFPS.HUD.BenchmarkThreatIndicators [Iterations] [MaxIndicators]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 Iterations = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 100;
+		const int32 MaxIndicators = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 8;
+
+		// view at origin looking along X, asteroids on sphere up to 1 km around
+		FMinimalViewInfo ViewInfo;
+		ViewInfo.FOV = 90.f;
+		ViewInfo.AspectRatio = 16.f / 9.f;
+		ViewInfo.bConstrainAspectRatio = true;
+
+		FMatrix ViewMatrix, ProjectionMatrix, ViewProjectionMatrix;
+		UGameplayStatics::GetViewProjectionMatrix(ViewInfo, ViewMatrix, ProjectionMatrix, ViewProjectionMatrix);
+
+		FRandomStream Stream(1);
+		FAsteroidThreatIndicators ThreatIndicators;
+		TArray<FVector> Positions;
+
+		// behind-left asteroid (view right is +Y) indicator must point left
+		Positions.Add(FVector(-1000.f, -500.f, 0.f));
+		ThreatIndicators.Update(ViewInfo.Location, ViewProjectionMatrix, Positions, MaxIndicators);
+		const bool bBehindLeftPassed = ThreatIndicators.GetIndicators().Num() == 1 && ThreatIndicators.GetIndicators()[0].Direction.X < 0.f;
+		UE_LOG(LogTemp, Display, TEXT("[ThreatIndicators] behind-left side %s"), bBehindLeftPassed ? TEXT("PASSED") : TEXT("FAILED"));
+
+		for (const int32 AsteroidNum : { 1000, 10000 })
+		{
+			Positions.Reset(AsteroidNum);
+			for (int32 It = 0; It != AsteroidNum; ++It)
+			{
+				Positions.Add(Stream.GetUnitVector() * Stream.FRandRange(1000.f, TRACE_DIST_MAX));
+			}
+
+			// first run allocates buffers
+			ThreatIndicators.Update(ViewInfo.Location, ViewProjectionMatrix, Positions, MaxIndicators);
+
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 It = 0; It != Iterations; ++It)
+			{
+				ThreatIndicators.Update(ViewInfo.Location, ViewProjectionMatrix, Positions, MaxIndicators);
+			}
+			const double AvgMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / Iterations;
+
+			UE_LOG(LogTemp, Display, TEXT("[ThreatIndicators] %d asteroids, %d indicators: %.4f ms per update (%d iterations), nearest %.1f"),
+				AsteroidNum, MaxIndicators, AvgMs, Iterations, ThreatIndicators.GetIndicators().Num() ? ThreatIndicators.GetIndicators()[0].Distance : 0.f);
+		}
+	})
+);
+
+void FAsteroidThreatIndicators::Update(const FVector& ViewLocation, const FMatrix& ViewProjectionMatrix, TArrayView<const FVector> Positions, int32 MaxIndicators)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ThreatIndicatorsUpdate);
+
+	Indicators.Reset();
+
+	if (MaxIndicators <= 0 || Positions.Num() == 0)
+	{
+		return;
+	}
+
+	const int32 ChunkNum = FMath::DivideAndRoundUp(Positions.Num(), ChunkSize);
+	ChunkCandidates.SetNumUninitialized(ChunkNum * MaxIndicators, false);
+	ChunkCandidateNum.SetNumZeroed(ChunkNum, false);
+
+	ParallelFor(ChunkNum, [&](int32 ChunkIndex)
+	{
+		FThreatIndicator* Candidates = ChunkCandidates.GetData() + ChunkIndex * MaxIndicators;
+		int32& CandidateNum = ChunkCandidateNum[ChunkIndex];
+
+		const int32 First = ChunkIndex * ChunkSize;
+		const int32 End = FMath::Min(First + ChunkSize, Positions.Num());
+
+		for (int32 It = First; It != End; ++It)
+		{
+			const float Distance = FVector::Dist(Positions[It], ViewLocation);
+			if (CandidateNum == MaxIndicators && Distance >= Candidates[CandidateNum - 1].Distance)
+			{
+				continue;  // farther than all kept candidates
+			}
+
+			// on screen asteroids don't need indicator
+			const FPlane Clip = ViewProjectionMatrix.TransformFVector4(FVector4(Positions[It], 1.f));
+			if (Clip.W > 0.f && FMath::Abs(Clip.X) <= Clip.W && FMath::Abs(Clip.Y) <= Clip.W)
+			{
+				continue;
+			}
+
+			// clip X/Y are not divided by W, so they keep view side also behind view, only X/W and Y/W flip there
+			FVector2D Direction = FVector2D(Clip.X, -Clip.Y).GetSafeNormal();
+			if (Direction.IsZero())
+			{
+				Direction = FVector2D(0.f, 1.f);  // right behind view
+			}
+
+			// insert keeping candidates sorted, farthest is dropped when full
+			int32 InsertIndex = CandidateNum < MaxIndicators ? CandidateNum++ : MaxIndicators - 1;
+			for (; InsertIndex > 0 && Candidates[InsertIndex - 1].Distance > Distance; --InsertIndex)
+			{
+				Candidates[InsertIndex] = Candidates[InsertIndex - 1];
+			}
+			Candidates[InsertIndex] = { Direction, Distance, It };
+		}
+	});
+
+	// merge chunks nearest
+	for (int32 ChunkIndex = 0; ChunkIndex != ChunkNum; ++ChunkIndex)
+	{
+		Indicators.Append(ChunkCandidates.GetData() + ChunkIndex * MaxIndicators, ChunkCandidateNum[ChunkIndex]);
+	}
+
+	SET_DWORD_STAT(STAT_ThreatIndicatorsCandidates, Indicators.Num());
+
+	Indicators.Sort([](const FThreatIndicator& A, const FThreatIndicator& B) { return A.Distance < B.Distance; });
+	Indicators.SetNum(FMath::Min(Indicators.Num(), MaxIndicators), false);
+}
@@ -8,6 +8,15 @@
 #include "DrawDebugHelpers.h"
 
 #include "Character/AFPS_Weapon.h"
+#include "Components/AFPS_HealthComponent.h"
+#include "AFPS_ScopeStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Look Trace Sync"), STAT_LookTraceSync, STATGROUP_FPSAsteroid);
+DECLARE_CYCLE_STAT(TEXT("Look Trace Async Request"), STAT_LookTraceAsyncRequest, STATGROUP_FPSAsteroid);
+DECLARE_CYCLE_STAT(TEXT("Look Trace Async Complete"), STAT_LookTraceAsyncComplete, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Look Trace Age (frames)"), STAT_LookTraceAge, STATGROUP_FPSAsteroid);
+
+AFPS_DECLARE_SCOPE_STAT("Character Look Point Trace", CharacterLookPointTrace);
 
 TAutoConsoleVariable<bool> CVarDrawDebugCharacter(
 	TEXT("AFPS.DrawDebug.Character"),
@@ -16,6 +25,13 @@ TAutoConsoleVariable<bool> CVarDrawDebugCharacter(
 	ECVF_Cheat
 );
 
+TAutoConsoleVariable<bool> CVarAsyncLookTrace(
+	TEXT("AFPS.Character.AsyncLookTrace"),
+	true,
+	TEXT("Enable/Disable async character look point trace, async result is one frame old"),
+	ECVF_Default
+);
+
 
 AAFPS_Character::AAFPS_Character()
 {
@@ -68,6 +84,12 @@ AAFPS_Character::AAFPS_Character()
 	LookLineTraceChannel = ECollisionChannel::ECC_Camera;
 	LookTraceQueryParams.AddIgnoredActor(this);
 
+	LookTraceFrame = 0;
+	PendingLookTraceFrame = 0;
+	bPendingLookTraceReady = false;
+	LookTraceDelegate.BindUObject(this, &AAFPS_Character::OnLookTraceCompleted);
+
+	ViewQueryCache.MaxDistance = TRACE_DIST_MAX;
 }
 
 void AAFPS_Character::BeginPlay()
@@ -77,6 +99,12 @@ void AAFPS_Character::BeginPlay()
 	// change movement mode to fly
 	GetCharacterMovement()->SetMovementMode(EMovementMode::MOVE_Flying);
 
+	// health may be added by blueprint, player kills are reported in Player category
+	if (UAFPS_HealthComponent* HealthComp = FindComponentByClass<UAFPS_HealthComponent>())
+	{
+		HealthComp->SetKillCategory(EKillVictimCategory::Player);
+	}
+
 	// spawn weapon
 	SpawnWeaponAttached();
 
@@ -91,6 +119,8 @@ void AAFPS_Character::Tick(float DeltaTime)
 
 	LookPointTrace();
 
+	SET_DWORD_STAT(STAT_LookTraceAge, GetLookTraceAgeFrames());
+
 	#if WITH_EDITOR
 	if (CVarDrawDebugCharacter.GetValueOnGameThread() &&
 		CVarDrawDebugGlobal.GetValueOnGameThread())
@@ -194,6 +224,78 @@ FORCEINLINE void AAFPS_Character::DrawDebug()
 	DrawDebugString(GetWorld(), LookPoint, FString::SanitizeFloat(LookDistance) + " m", 0, FColor::Yellow, 0.f, true);
 }
 
+void AAFPS_Character::LookPointTrace()
+{
+	AFPS_SCOPE_STAT(CharacterLookPointTrace);
+
+	// show async result from previous frame
+	if (bPendingLookTraceReady)
+	{
+		Swap(LookTrace, PendingLookTrace);
+		LookTraceFrame = PendingLookTraceFrame;
+		bPendingLookTraceReady = false;
+	}
+
+	FVector EyeLocation;
+	FRotator EyeRotation;
+	GetActorEyesViewPoint(EyeLocation, EyeRotation);
+	const FVector EyeDirection = EyeRotation.Vector();
+
+	// eye ray was already traced this frame (e.g. by weapon shot)
+	if (ViewQueryCache.IsValidFor(EyeLocation, EyeDirection, LookLineTraceChannel))
+	{
+		ViewQueryCache.Query(GetWorld(), EyeLocation, EyeDirection, TRACE_DIST_MAX, LookLineTraceChannel, LookTraceQueryParams, LookTrace);
+		LookTraceFrame = GFrameCounter;
+		return;
+	}
+
+	if (CVarAsyncLookTrace.GetValueOnGameThread())
+	{
+		// while firing weapon traced eye ray of its last shot last frame, it's as old as async result would be,
+		// so look point shares it instead of requesting one more trace
+		uint64 SharedFrame;
+		if (ViewQueryCache.GetPreviousFrameHit(LookLineTraceChannel, LookTrace, SharedFrame))
+		{
+			LookTraceFrame = SharedFrame;
+			return;
+		}
+
+		SCOPE_CYCLE_COUNTER(STAT_LookTraceAsyncRequest);
+
+		// frame number is passed as user data to drop outdated results
+		GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, EyeLocation, EyeLocation + EyeDirection * TRACE_DIST_MAX, LookLineTraceChannel,
+			LookTraceQueryParams, FCollisionResponseParams::DefaultResponseParam, &LookTraceDelegate, static_cast<uint32>(GFrameCounter));
+	}
+	else
+	{
+		SCOPE_CYCLE_COUNTER(STAT_LookTraceSync);
+
+		ViewQueryCache.Query(GetWorld(), EyeLocation, EyeDirection, TRACE_DIST_MAX, LookLineTraceChannel, LookTraceQueryParams, LookTrace);
+		LookTraceFrame = GFrameCounter;
+	}
+}
+
+bool AAFPS_Character::QueryViewHit(const FVector& Start, const FVector& Direction, float Range, ECollisionChannel Channel, FHitResult& OutHit)
+{
+	return ViewQueryCache.Query(GetWorld(), Start, Direction, Range, Channel, LookTraceQueryParams, OutHit);
+}
+
+void AAFPS_Character::OnLookTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LookTraceAsyncComplete);
+
+	// restore full frame number from 32 bit user data
+	const uint64 RequestFrame = (GFrameCounter & ~uint64(MAX_uint32)) | TraceDatum.UserData;
+	if (RequestFrame < LookTraceFrame || (bPendingLookTraceReady && RequestFrame < PendingLookTraceFrame))
+	{
+		return;  // newer result is already there
+	}
+
+	PendingLookTrace = TraceDatum.OutHits.Num() ? TraceDatum.OutHits[0] : FHitResult();
+	PendingLookTraceFrame = RequestFrame;
+	bPendingLookTraceReady = true;
+}
+
 void AAFPS_Character::SpawnWeaponAttached(bool bDestroyOldWeapon)
 {
 	if (bDestroyOldWeapon && WeaponInHands)
@@ -208,6 +310,15 @@ void AAFPS_Character::SpawnWeaponAttached(bool bDestroyOldWeapon)
 	WeaponInHands->OnAttach(this);
 
 	LookTraceQueryParams.AddIgnoredActor(WeaponInHands);
+
+	NotifyWeaponChanged.Broadcast();
+}
+
+void AAFPS_Character::UnPossessed()
+{
+	Super::UnPossessed();
+
+	NotifyWeaponChanged.Broadcast();
 }
 
 void AAFPS_Character::PlayFireAnimMontage()
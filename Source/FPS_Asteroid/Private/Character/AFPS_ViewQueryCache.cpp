@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Character/AFPS_ViewQueryCache.h"
+
+#include <FPS_Asteroid/FPS_Asteroid.h>
+
+DECLARE_CYCLE_STAT(TEXT("View Query Trace"), STAT_ViewQueryTrace, STATGROUP_FPSAsteroid);
+DECLARE_CYCLE_STAT(TEXT("View Query Complex Refine"), STAT_ViewQueryComplexRefine, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_COUNTER_STAT(TEXT("View Query Traces"), STAT_ViewQueryTraces, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_COUNTER_STAT(TEXT("View Query Traces Saved"), STAT_ViewQueryTracesSaved, STATGROUP_FPSAsteroid);
+
+bool FViewQueryCache::Query(const UWorld* World, const FVector& InStart, const FVector& InDirection, float Range, ECollisionChannel InChannel,
+	const FCollisionQueryParams& Params, FHitResult& OutHit)
+{
+	if (Range > MaxDistance)
+	{
+		// not cacheable, trace as is
+		INC_DWORD_STAT(STAT_ViewQueryTraces);
+		SCOPE_CYCLE_COUNTER(STAT_ViewQueryTrace);
+
+		return World->LineTraceSingleByChannel(OutHit, InStart, InStart + InDirection * Range, InChannel, Params);
+	}
+
+	if (IsValidFor(InStart, InDirection, InChannel))
+	{
+		INC_DWORD_STAT(STAT_ViewQueryTracesSaved);
+	}
+	else
+	{
+		Start = InStart;
+		Direction = InDirection;
+		Channel = InChannel;
+		Frame = GFrameCounter;
+
+		Trace(World, Params);
+	}
+
+	if (Hit.bBlockingHit && Hit.Distance <= Range)
+	{
+		OutHit = Hit;
+		return true;
+	}
+
+	OutHit = FHitResult();
+	return false;
+}
+
+bool FViewQueryCache::IsValidFor(const FVector& InStart, const FVector& InDirection, ECollisionChannel InChannel) const
+{
+	return Frame == GFrameCounter && Channel == InChannel && 
+		Start.Equals(InStart, KINDA_SMALL_NUMBER) && Direction.Equals(InDirection, KINDA_SMALL_NUMBER);
+}
+
+bool FViewQueryCache::GetPreviousFrameHit(ECollisionChannel InChannel, FHitResult& OutHit, uint64& OutFrame) const
+{
+	if (Frame + 1 != GFrameCounter || Channel != InChannel)
+	{
+		return false;
+	}
+
+	INC_DWORD_STAT(STAT_ViewQueryTracesSaved);
+
+	OutHit = Hit;
+	OutFrame = Frame;
+	return true;
+}
+
+void FViewQueryCache::Trace(const UWorld* World, const FCollisionQueryParams& Params)
+{
+	INC_DWORD_STAT(STAT_ViewQueryTraces);
+	SCOPE_CYCLE_COUNTER(STAT_ViewQueryTrace);
+
+	const FVector End = Start + Direction * MaxDistance;
+
+	FCollisionQueryParams SimpleParams = Params;
+	SimpleParams.bTraceComplex = false;
+
+	if (!World->LineTraceSingleByChannel(Hit, Start, End, Channel, SimpleParams))
+	{
+		return;
+	}
+
+	// per poly trace is worth it only when hit is close enough to see the difference
+	UPrimitiveComponent* HitComponent = Hit.GetComponent();
+	if (HitComponent && Hit.Distance <= ComplexRefineDistance)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ViewQueryComplexRefine);
+
+		static const FCollisionQueryParams ComplexParams(SCENE_QUERY_STAT(ViewQueryComplexRefine), true);
+
+		FHitResult ComplexHit;
+		if (HitComponent->LineTraceComponent(ComplexHit, Start, End, ComplexParams))
+		{
+			// keep hit item, instanced mesh trace can report it differently
+			ComplexHit.Item = ComplexHit.Item != INDEX_NONE ? ComplexHit.Item : Hit.Item;
+			Hit = ComplexHit;
+		}
+		// no per poly hit inside simple hull, simple hit is kept
+	}
+}
@@ -4,12 +4,19 @@
 #include "Character/AFPS_Weapon.h"
 #include "Engine/CollisionProfile.h"
 #include "DrawDebugHelpers.h"
+#include "GameFramework/PlayerController.h"
 #include "Kismet/GameplayStatics.h"
 
 #include "Character/AFPS_Character.h"
+#include "Components/AFPS_DamageQueueComponent.h"
+#include "AFPS_GameMode.h"
+#include "AFPS_HUD.h"
+#include "AFPS_ScopeStats.h"
 
 #include <FPS_Asteroid/FPS_Asteroid.h>
 
+AFPS_DECLARE_SCOPE_STAT("Weapon Shot Trace", WeaponShotTrace);
+
 TAutoConsoleVariable<bool> CVarDrawDebugWeapon(
 	TEXT("AFPS.DrawDebug.Weapon"),
 	true,
@@ -17,6 +24,15 @@ TAutoConsoleVariable<bool> CVarDrawDebugWeapon(
 	ECVF_Cheat
 );
 
+TAutoConsoleVariable<bool> CVarFastShotTrace(
+	TEXT("AFPS.Weapon.FastShotTrace"),
+	false,
+	TEXT("Enable/Disable weapon shot trace against asteroid bounding spheres, only asteroids can be hit"),
+	ECVF_Default
+);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Shots"), STAT_WeaponShots, STATGROUP_FPSAsteroid);
+
 AAFPS_Weapon::AAFPS_Weapon()
 {
 	// tick enable
@@ -44,6 +60,7 @@ AAFPS_Weapon::AAFPS_Weapon()
 	Damage = 10.f;
 	StartFireDelay = 0.5f;
 	FireRate = 0.1f;
+	MaxShotsPerFrame = 8;
 	EnergyLevel = 100.f;
 	EnergyRecoveryRate = 50.f;  // 2 sec recovery
 	EnergyDrainPerShot = 5.f;   // 2 sec shooting
@@ -51,24 +68,36 @@ AAFPS_Weapon::AAFPS_Weapon()
 	DamageType = UDamageType::StaticClass();
 	
 	ShotLineTraceChannel = ECollisionChannel::ECC_Camera;
-
-	HitTraceQueryParams.AddIgnoredActor(this);
-	HitTraceQueryParams.bTraceComplex = true;
 }
 
 void AAFPS_Weapon::BeginPlay()
 {
 	Super::BeginPlay();
 
-	CurrentEnergyLevel = EnergyLevel;
-	EnergyLevelTarget = EnergyLevel;
+	SetEnergySegment(GetWorld()->GetTimeSeconds(), EnergyLevel, 0.f, EnergyLevel);
+	LastNotifiedEnergyAlpha = 1.f;
+
+	#if !WITH_EDITOR
+	SetActorTickEnabled(false);  // full and idle, tick is needed only for draw debug in editor
+	#endif  // !WITH_EDITOR
 }
 
 void AAFPS_Weapon::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
-	OnTickCalculateEnergyLevel(DeltaTime);
+	FireScheduledShots();
+
+	ProcessEnergyEvents();
+
+	CachePrevEyeViewPoint();
+
+	#if !WITH_EDITOR
+	if (!bIsFiring && EnergyRate == 0.f)
+	{
+		SetActorTickEnabled(false);  // nothing is scheduled, tick is needed only for draw debug in editor
+	}
+	#endif  // !WITH_EDITOR
 
 	#if WITH_EDITOR
 	if (CVarDrawDebugWeapon.GetValueOnGameThread() &&
@@ -103,8 +132,6 @@ void AAFPS_Weapon::OnAttach(AAFPS_Character* InCharacterOwner)
 	{
 		CharacterOwner = InCharacterOwner;
 		SetOwner(InCharacterOwner);
-
-		HitTraceQueryParams.AddIgnoredActor(InCharacterOwner);
 	}
 }
 
@@ -116,7 +143,7 @@ bool AAFPS_Weapon::CanStartShooting()
 
 bool AAFPS_Weapon::HasEnergyForSingleShot()
 {
-	return CurrentEnergyLevel >= EnergyDrainPerShot;
+	return GetCurrentEnergyLevel() >= EnergyDrainPerShot;
 }
 
 void AAFPS_Weapon::StartFire_Internal()
@@ -130,26 +157,28 @@ void AAFPS_Weapon::StartFire_Internal()
 	LastTimeWhenFiringStarts = GetWorld()->GetTimeSeconds();
 	bIsFiring = true;
 
+	// first shot is owed right now, next ones every FireRate seconds
+	NextShotTime = LastTimeWhenFiringStarts;
+	bHasPrevEye = false;
+
+	// all affordable shots are paid by linear drain, segment ends exactly when last paid shot period is over
+	const float StartEnergyLevel = CalcEnergyLevelAt(LastTimeWhenFiringStarts);
+	ShotsLeft = EnergyDrainPerShot > 0.f ? FMath::FloorToInt((StartEnergyLevel + KINDA_SMALL_NUMBER) / EnergyDrainPerShot) : MAX_int32;
+	SetEnergySegment(LastTimeWhenFiringStarts, StartEnergyLevel, -EnergyDrainPerShot / FireRate,
+		EnergyDrainPerShot > 0.f ? StartEnergyLevel - ShotsLeft * EnergyDrainPerShot : StartEnergyLevel);
+
+	SetActorTickEnabled(true);
+
 	CharacterOwner->PlayFireAnimMontage();  // character fire anim
 	PlayStartFireEffects(); // effects
 
-	FireLoop();
+	FireScheduledShots();
 }
 
-void AAFPS_Weapon::ResetShotTimer(bool bShouldReset)
+void AAFPS_Weapon::ShotLineTrace(const FVector& EyeLocation, const FRotator& EyeRotation)
 {
-	if (bShouldReset)
-	{
-		GetWorldTimerManager().SetTimer(TimerHandle_FireLoop, this, &AAFPS_Weapon::FireLoop, FireRate);
-	}
-	else
-	{
-		GetWorldTimerManager().ClearTimer(TimerHandle_FireLoop);
-	}
-}
+	AFPS_SCOPE_STAT(WeaponShotTrace);
 
-void AAFPS_Weapon::ShotLineTrace()
-{
 	if (CharacterOwner == nullptr)
 	{
 		UE_LOG(LogTemp, Warning, TEXT("AAFPS_Weapon::ShotLineTrace() CharacterOwner is nullptr"));
@@ -157,68 +186,171 @@ void AAFPS_Weapon::ShotLineTrace()
 		return;
 	}
 
-	FVector EyeLocation;
-	FRotator EyeRotation;
-	CharacterOwner->GetActorEyesViewPoint(EyeLocation, EyeRotation);
-
 	FVector ShotDirection = EyeRotation.Vector();
-	FVector ShotEnd = EyeLocation + ShotDirection * Range;
 
 	LastHit = FHitResult();  // flush old result
 
-	if (GetWorld()->LineTraceSingleByChannel(LastHit, EyeLocation, ShotEnd, ShotLineTraceChannel, HitTraceQueryParams))
+	AAFPS_GameMode* GM = GetWorld()->GetAuthGameMode<AAFPS_GameMode>();
+
+	// fast mode tests asteroid bounding spheres, otherwise eye ray trace is shared with character look point trace
+	const bool bHit = GM && CVarFastShotTrace.GetValueOnGameThread()
+		? GM->RaycastAsteroids(EyeLocation, ShotDirection, Range, LastHit)
+		: CharacterOwner->QueryViewHit(EyeLocation, ShotDirection, Range, ShotLineTraceChannel, LastHit);
+
+	if (bHit)
 	{
 		AActor* HitActor = LastHit.GetActor();
 
-		UGameplayStatics::ApplyPointDamage(HitActor, Damage, ShotDirection, LastHit, CharacterOwner->GetInstigatorController(), this, DamageType);
+		// damage is resolved by game mode once per frame if possible
+		if (UAFPS_DamageQueueComponent* DamageQueue = GM ? GM->GetDamageQueue() : nullptr)
+		{
+			DamageQueue->QueuePointDamage(HitActor, Damage, ShotDirection, LastHit, CharacterOwner->GetInstigatorController(), this, DamageType);
+		}
+		else
+		{
+			UGameplayStatics::ApplyPointDamage(HitActor, Damage, ShotDirection, LastHit, CharacterOwner->GetInstigatorController(), this, DamageType);
+		}
 
 		PlayHitEffects();  // effects
 	}
 }
 
-void AAFPS_Weapon::FireLoop()
+void AAFPS_Weapon::FireScheduledShots()
 {
-	EnergyLevelTarget = CurrentEnergyLevel - EnergyDrainPerShot;
+	if (!bIsFiring || CharacterOwner == nullptr)
+	{
+		return;
+	}
 
-	ShotLineTrace();
+	const float Now = GetWorld()->GetTimeSeconds();
+	if (NextShotTime > Now)
+	{
+		return;
+	}
 
-	PlayFireEffects(); // effects
+	FVector EyeLocation;
+	FRotator EyeRotation;
+	CharacterOwner->GetActorEyesViewPoint(EyeLocation, EyeRotation);
 
-	if (HasEnergyForSingleShot())
+	const FQuat PrevEyeQuat = PrevEyeRotation.Quaternion();
+	const FQuat EyeQuat = EyeRotation.Quaternion();
+	const float FrameTime = Now - PrevEyeTime;
+
+	// collect all shots owed since last frame, cadence is kept so energy drain stays exact
+	FrameShots.Reset();
+	while (NextShotTime <= Now && FrameShots.Num() < MaxShotsPerFrame && ShotsLeft > 0)
 	{
-		ResetShotTimer(true);  // prepare next shot
+		const float Alpha = bHasPrevEye && FrameTime > KINDA_SMALL_NUMBER ? FMath::Clamp((NextShotTime - PrevEyeTime) / FrameTime, 0.f, 1.f) : 1.f;
+
+		FrameShots.Add({ NextShotTime, FMath::Lerp(PrevEyeLocation, EyeLocation, Alpha), FQuat::Slerp(PrevEyeQuat, EyeQuat, Alpha).Rotator() });
+
+		--ShotsLeft;
+		NextShotTime += FireRate;
 	}
-	else
+
+	for (const FWeaponShot& Shot : FrameShots)
 	{
-		bEnergyWasDrained = true;
-		PlayEnergyDrainedEffects(); // effects
+		LastShotTime = Shot.Time;
+		ShotLineTrace(Shot.EyeLocation, Shot.EyeRotation);
+	}
 
-		StopFire_Internal();
+	INC_DWORD_STAT_BY(STAT_WeaponShots, FrameShots.Num());
+
+	if (FrameShots.Num())
+	{
+		PlayFireEffects(); // effects, once per frame batch
+	}
+}
+
+void AAFPS_Weapon::CachePrevEyeViewPoint()
+{
+	if (CharacterOwner)
+	{
+		CharacterOwner->GetActorEyesViewPoint(PrevEyeLocation, PrevEyeRotation);
+		PrevEyeTime = GetWorld()->GetTimeSeconds();
+		bHasPrevEye = true;
 	}
 }
 
 void AAFPS_Weapon::StopFire_Internal()
 {
-	EnergyLevelTarget = EnergyLevel;
+	// recovery starts at stop or at drained event if it is already passed, fired shots are fully paid
+	if (bIsFiring)
+	{
+		const float StopTime = FMath::Min(GetWorld()->GetTimeSeconds(), EnergyEventTime);
+		const float StopEnergyLevel = FMath::Min(CalcEnergyLevelAt(StopTime), EnergyLimitLevel + ShotsLeft * EnergyDrainPerShot);
 
-	ResetShotTimer(false); // stop shooting loop
-	bIsFiring = false;
+		SetEnergySegment(StopTime, StopEnergyLevel, EnergyRecoveryRate, EnergyLevel);
+	}
+
+	ShotsLeft = 0;
+	bIsFiring = false; // stop shooting loop
 
 	PlayEndFireEffects(); // effects
 }
 
-FORCEINLINE void AAFPS_Weapon::OnTickCalculateEnergyLevel(float DeltaSeconds)
+float AAFPS_Weapon::CalcEnergyLevelAt(float Time) const
+{
+	const float Level = EnergyAnchorLevel + EnergyRate * (Time - EnergyAnchorTime);
+	return EnergyRate < 0.f ? FMath::Max(Level, EnergyLimitLevel) : FMath::Min(Level, EnergyLimitLevel);
+}
+
+float AAFPS_Weapon::GetCurrentEnergyLevel() const
+{
+	return CalcEnergyLevelAt(GetWorld()->GetTimeSeconds());
+}
+
+void AAFPS_Weapon::SetEnergySegment(float Time, float Level, float Rate, float LimitLevel)
+{
+	// segment which is already at its limit is idle
+	if ((Rate > 0.f && Level >= LimitLevel) || (Rate < 0.f && Level <= LimitLevel))
+	{
+		Rate = 0.f;
+	}
+
+	EnergyAnchorTime = Time;
+	EnergyAnchorLevel = Level;
+	EnergyRate = Rate;
+	EnergyLimitLevel = Rate != 0.f ? LimitLevel : Level;
+	EnergyEventTime = Rate != 0.f ? Time + (LimitLevel - Level) / Rate : Time;
+
+	if (Rate != 0.f)
+	{
+		SetActorTickEnabled(true);  // event must be executed
+	}
+}
+
+void AAFPS_Weapon::ProcessEnergyEvents()
 {
-	float InterpSpeed = bIsFiring ? (EnergyDrainPerShot / FireRate) : EnergyRecoveryRate;
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	// drained waits for shots owed from segment, they may be deferred by MaxShotsPerFrame
+	if (bIsFiring && ShotsLeft == 0 && Now >= EnergyEventTime)
+	{
+		bEnergyWasDrained = true;
+		PlayEnergyDrainedEffects(); // effects
 
-	CurrentEnergyLevel = FMath::FInterpConstantTo(CurrentEnergyLevel, EnergyLevelTarget, DeltaSeconds, InterpSpeed);
+		StopFire_Internal();
+	}
 
-	if (bEnergyWasDrained && CurrentEnergyLevel == EnergyLevel)
+	if (!bIsFiring && EnergyRate > 0.f && Now >= EnergyEventTime)
 	{
-		bEnergyWasDrained = false;
-		PlayEnergyRestoredEffects();  // effects
+		SetEnergySegment(EnergyEventTime, EnergyLimitLevel, 0.f, EnergyLimitLevel);
 
-		if (bWantsToFire) StartFire_Internal();  // run fire loop
+		if (bEnergyWasDrained)
+		{
+			bEnergyWasDrained = false;
+			PlayEnergyRestoredEffects();  // effects
+
+			if (bWantsToFire) StartFire_Internal();  // run fire loop
+		}
+	}
+
+	const float EnergyAlpha = GetEnergyLevelAlpha();
+	if (EnergyAlpha != LastNotifiedEnergyAlpha)
+	{
+		LastNotifiedEnergyAlpha = EnergyAlpha;
+		NotifyEnergyChanged.Broadcast(EnergyAlpha);
 	}
 }
 
@@ -252,6 +384,7 @@ void AAFPS_Weapon::PlayEnergyRestoredEffects()
 	OnPlayEnergyRestoredEffects(); // Calling blueprint version
 }
 
+#if WITH_EDITOR
 FORCEINLINE void AAFPS_Weapon::DrawDebug(float DeltaSeconds)
 {
 	FVector DrawLocation = MeshComp->GetSocketLocation(MuzzleSocketName);
@@ -259,8 +392,19 @@ FORCEINLINE void AAFPS_Weapon::DrawDebug(float DeltaSeconds)
 	// muzzle socket
 	DrawDebugSphere(GetWorld(), DrawLocation, 3.f, 4, FColor::Yellow, false, -1.f, 1);
 
+	DebugText.Begin();
+	DebugText.AddLine(TEXT("bWantsToFire: %s"), bWantsToFire ? TEXT("true") : TEXT("false"));
+	DebugText.AddLine(TEXT("bEnergyWasDrained: %s"), bEnergyWasDrained ? TEXT("true") : TEXT("false"));
+	DebugText.AddLine(TEXT("bIsFiring: %s"), bIsFiring ? TEXT("true") : TEXT("false"));
+	DebugText.AddLine(TEXT("EnergyCurrent: %.3f"), GetCurrentEnergyLevel());
+	DebugText.AddLine(TEXT("EnergyLimit: %.3f"), EnergyLimitLevel);
+	DebugText.AddLine(TEXT("EnergyRate: %.3f"), EnergyRate);
+	DebugText.AddLine(TEXT("EnergyEventIn: %.3f"), EnergyRate != 0.f ? EnergyEventTime - GetWorld()->GetTimeSeconds() : 0.f);
+	DebugText.AddLine(TEXT("ShotsLeft: %d"), ShotsLeft);
+	DebugText.AddLine(TEXT("ShotsLastBatch: %d"), FrameShots.Num());
+	DebugText.AddLine(TEXT("NextShotIn: %.3f"), bIsFiring ? NextShotTime - GetWorld()->GetTimeSeconds() : 0.f);
+
 	// dbg shooting time msg
-	FString ShootTimeMsg;
 	{
 		static float ShootingTimer;
 		static float NotShootingTimer;
@@ -269,25 +413,31 @@ FORCEINLINE void AAFPS_Weapon::DrawDebug(float DeltaSeconds)
 		{
 			ShootingTimer += DeltaSeconds;
 			NotShootingTimer = 0.f;
-			ShootTimeMsg = "\nShootingTime: " + FString::SanitizeFloat(ShootingTimer);
+			DebugText.AddLine(TEXT("ShootingTime: %.2f"), ShootingTimer);
 		}
 		else
 		{
 			NotShootingTimer += DeltaSeconds;
 			ShootingTimer = 0.f;
-			ShootTimeMsg = "\nNotShootingTime: " + FString::SanitizeFloat(NotShootingTimer);
+			DebugText.AddLine(TEXT("NotShootingTime: %.2f"), NotShootingTimer);
 		}
 	}
 
-	FString Msg = "bWantsToFire: " + FString(bWantsToFire ? "true" : "false") + 
-		"\nbEnergyWasDrained: " + FString(bEnergyWasDrained ? "true" : "false") +
-		"\nbIsFiring: " + FString((bIsFiring ? "true" : "false")) +
-		"\nEnergyCurrent: " + FString::SanitizeFloat(CurrentEnergyLevel) + 
-		"\nEnergyTarget:" + FString::SanitizeFloat(EnergyLevelTarget) +
-		"\nEnergyInterpSpeed:" + FString::SanitizeFloat(bIsFiring ? (EnergyDrainPerShot / FireRate) : EnergyRecoveryRate)
-		+ ShootTimeMsg;
+	// recent frames, shooting cost is visible while firing
+	if (AAFPS_GameMode* GM = GetWorld()->GetAuthGameMode<AAFPS_GameMode>())
+	{
+		const FFrameTimeTracker& FrameTimes = GM->GetFrameTimeTracker();
+		DebugText.AddLine(TEXT("RecentFrameMs p50/p95/p99: %.1f/%.1f/%.1f"), FrameTimes.CalcRecentPercentileMs(0.5f),
+			FrameTimes.CalcRecentPercentileMs(0.95f), FrameTimes.CalcRecentPercentileMs(0.99f));
+	}
+
+	DebugText.End();
 
-	DrawDebugString(GetWorld(), DrawLocation, Msg, 0, FColor::Cyan, 0.f, true);
+	APlayerController* PC = GetWorld()->GetFirstPlayerController();
+	if (AAFPS_HUD* HUD = PC ? Cast<AAFPS_HUD>(PC->GetHUD()) : nullptr)
+	{
+		HUD->AddDebugText(this, DebugText, DrawLocation, FColor::Cyan);
+	}
 
 	// draw debug last hit
 	if (LastHit.bBlockingHit)
@@ -295,3 +445,4 @@ FORCEINLINE void AAFPS_Weapon::DrawDebug(float DeltaSeconds)
 		DrawDebugSphere(GetWorld(), LastHit.Location, 10.f, 4, FColor::Yellow, false, -1.f, 0, 1.f);
 	}
 }
+#endif // WITH_EDITOR
@@ -0,0 +1,144 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Components/AFPS_AsteroidPhysicsLODComponent.h"
+#include "GameFramework/PlayerController.h"
+
+#include <FPS_Asteroid/FPS_Asteroid.h>
+#include <FPS_Asteroid/Public/AFPS_Asteroid.h>
+#include <FPS_Asteroid/Public/AFPS_GameMode.h>
+
+DECLARE_CYCLE_STAT(TEXT("Asteroid Physics LOD Update"), STAT_AsteroidPhysicsLODUpdate, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Asteroid Bodies Active"), STAT_AsteroidBodiesActive, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Asteroid Bodies Sleeping"), STAT_AsteroidBodiesSleeping, STATGROUP_FPSAsteroid);
+
+// Sets default values for this component's properties
+UAFPS_AsteroidPhysicsLODComponent::UAFPS_AsteroidPhysicsLODComponent()
+{
+	// bodies state is changed slowly, no need to check every frame
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.TickInterval = 0.25f;
+
+	SleepDistance = 20'000.f;  // 200 m
+	NearSleepDelay = 10.f;
+	FarSleepDelay = 1.f;
+
+	ActiveBodyNum = 0;
+	SleepingBodyNum = 0;
+	StepStartSeconds = 0.0;
+	AwakeBodySeconds = 0.0;
+}
+
+void UAFPS_AsteroidPhysicsLODComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (FPhysScene* PhysScene = GetWorld()->GetPhysicsScene())
+	{
+		PhysScenePreTickHandle = PhysScene->OnPhysScenePreTick.AddUObject(this, &UAFPS_AsteroidPhysicsLODComponent::OnPhysScenePreTick);
+		PhysScenePostTickHandle = PhysScene->OnPhysScenePostTick.AddUObject(this, &UAFPS_AsteroidPhysicsLODComponent::OnPhysScenePostTick);
+	}
+}
+
+void UAFPS_AsteroidPhysicsLODComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (FPhysScene* PhysScene = GetWorld()->GetPhysicsScene())
+	{
+		PhysScene->OnPhysScenePreTick.Remove(PhysScenePreTickHandle);
+		PhysScene->OnPhysScenePostTick.Remove(PhysScenePostTickHandle);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UAFPS_AsteroidPhysicsLODComponent::OnPhysScenePreTick(FPhysScene* PhysScene, float DeltaSeconds)
+{
+	StepStartSeconds = FPlatformTime::Seconds();
+}
+
+void UAFPS_AsteroidPhysicsLODComponent::OnPhysScenePostTick(FPhysScene* PhysScene)
+{
+	if (StepStartSeconds == 0.0)
+	{
+		return;
+	}
+
+	const double StepSeconds = FPlatformTime::Seconds() - StepStartSeconds;
+	StepStartSeconds = 0.0;
+
+	AAFPS_GameMode* GM = Cast<AAFPS_GameMode>(GetOwner());
+	UAFPS_AsteroidSignificanceComponent* Significance = GM ? GM->GetAsteroidSignificance() : nullptr;
+	if (Significance == nullptr || !IsComponentTickEnabled())
+	{
+		return;
+	}
+
+	// step time is shared by awake asteroid bodies (other bodies are few), sleeping body would cost the same,
+	// cost is kept from last frame with awake asteroids
+	if (ActiveBodyNum)
+	{
+		AwakeBodySeconds = StepSeconds / ActiveBodyNum;
+	}
+
+	Significance->AddSavedSeconds(AwakeBodySeconds * SleepingBodyNum);
+}
+
+void UAFPS_AsteroidPhysicsLODComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AsteroidPhysicsLODUpdate);
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	AAFPS_GameMode* GM = Cast<AAFPS_GameMode>(GetOwner());
+	APlayerController* PC = GetWorld()->GetFirstPlayerController();
+	if (GM == nullptr || PC == nullptr)
+	{
+		return;
+	}
+
+	// low significance asteroids (far or out of view) are treated as far
+	const UAFPS_AsteroidSignificanceComponent* Significance = GM->GetAsteroidSignificance();
+
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	PC->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+	const float SleepDistanceSq = FMath::Square(SleepDistance);
+	const float TimeSeconds = GetWorld()->GetTimeSeconds();
+
+	ActiveBodyNum = 0;
+	SleepingBodyNum = 0;
+
+	for (AAFPS_Asteroid* Asteroid : GM->GetLiveAsteroids())
+	{
+		FBodyInstance* Body = Asteroid ? Asteroid->GetMesh()->GetBodyInstance() : nullptr;
+		if (Body == nullptr || !Body->IsInstanceSimulatingPhysics())
+		{
+			continue;
+		}
+
+		if (!Body->IsInstanceAwake())
+		{
+			++SleepingBodyNum;
+			continue;
+		}
+
+		const bool bFar = Significance
+			? Asteroid->GetSignificance() >= EAsteroidSignificance::Low
+			: FVector::DistSquared(ViewLocation, Asteroid->GetActorLocation()) > SleepDistanceSq;
+		const float SleepDelay = bFar ? FarSleepDelay : NearSleepDelay;
+
+		if (TimeSeconds - Asteroid->GetLastHitTime() >= SleepDelay)
+		{
+			Body->PutInstanceToSleep();
+			++SleepingBodyNum;
+		}
+		else
+		{
+			++ActiveBodyNum;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_AsteroidBodiesActive, ActiveBodyNum);
+	SET_DWORD_STAT(STAT_AsteroidBodiesSleeping, SleepingBodyNum);
+}
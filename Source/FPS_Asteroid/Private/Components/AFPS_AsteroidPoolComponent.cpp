@@ -0,0 +1,167 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Components/AFPS_AsteroidPoolComponent.h"
+
+#include <FPS_Asteroid/FPS_Asteroid.h>
+#include <FPS_Asteroid/Public/AFPS_Asteroid.h>
+#include <FPS_Asteroid/Public/AFPS_GameMode.h>
+#include <FPS_Asteroid/Public/AFPS_AsteroidSpawner.h>
+
+DECLARE_CYCLE_STAT(TEXT("Asteroid Pool Acquire"), STAT_AsteroidPoolAcquire, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Asteroid Pool Free"), STAT_AsteroidPoolFree, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Asteroid Pool Hits"), STAT_AsteroidPoolHits, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Asteroid Pool Misses"), STAT_AsteroidPoolMisses, STATGROUP_FPSAsteroid);
+
+static FAutoConsoleCommandWithWorldAndArgs AsteroidPoolBenchmarkCmd(
+	TEXT("AFPS.AsteroidPool.Benchmark"),
+	TEXT("Time SpawnActor/Destroy of asteroids against pool Acquire/Release. Usage: AFPS.AsteroidPool.Benchmark [Num]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		AAFPS_GameMode* GM = World ? World->GetAuthGameMode<AAFPS_GameMode>() : nullptr;
+		if (GM == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("[AsteroidPool] Benchmark: no game mode"));
+			return;
+		}
+
+		const int32 Num = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1000;
+
+		// same class as waves spawn, far below play area
+		const TSubclassOf<AAFPS_Asteroid> AsteroidClass = GM->GetAsteroidSpawner()
+			? GM->GetAsteroidSpawner()->GetSpawnParam().AsteroidClass : TSubclassOf<AAFPS_Asteroid>(AAFPS_Asteroid::StaticClass());
+		const FTransform SpawnTransform(FVector(0.f, 0.f, -1'000'000'00.f));
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		TArray<AAFPS_Asteroid*> Asteroids;
+		Asteroids.Reserve(Num);
+
+		// without pool
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 It = 0; It != Num; ++It)
+		{
+			Asteroids.Add(World->SpawnActor<AAFPS_Asteroid>(AsteroidClass, SpawnTransform, SpawnParams));
+		}
+		const double SpawnMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		StartTime = FPlatformTime::Seconds();
+		for (AAFPS_Asteroid* Asteroid : Asteroids)
+		{
+			if (Asteroid) Asteroid->Destroy();
+		}
+		const double DestroyMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		// with pool, separate from game mode pool so its hit/miss counters are not touched,
+		// acquired asteroids still register with the live registry and ray caster like pooled game asteroids
+		UAFPS_AsteroidPoolComponent* Pool = NewObject<UAFPS_AsteroidPoolComponent>(GM);
+		Pool->Prewarm(AsteroidClass, Num);
+
+		Asteroids.Reset();
+		StartTime = FPlatformTime::Seconds();
+		for (int32 It = 0; It != Num; ++It)
+		{
+			Asteroids.Add(Pool->Acquire(AsteroidClass, SpawnTransform));
+		}
+		const double AcquireMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		StartTime = FPlatformTime::Seconds();
+		for (AAFPS_Asteroid* Asteroid : Asteroids)
+		{
+			Pool->Release(Asteroid);
+		}
+		const double ReleaseMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		UE_LOG(LogTemp, Display, TEXT("[AsteroidPool] %d asteroids: SpawnActor %.3f ms, Destroy %.3f ms, Acquire %.3f ms, Release %.3f ms, pool hits %d misses %d"),
+			Num, SpawnMs, DestroyMs, AcquireMs, ReleaseMs, Pool->GetPoolHits(), Pool->GetPoolMisses());
+
+		Pool->DestroyFreeAsteroids();
+		Pool->MarkPendingKill();
+	})
+);
+
+// Sets default values for this component's properties
+UAFPS_AsteroidPoolComponent::UAFPS_AsteroidPoolComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UAFPS_AsteroidPoolComponent::Prewarm(TSubclassOf<AAFPS_Asteroid> AsteroidClass, int32 Num)
+{
+	FreeAsteroids.Reserve(FreeAsteroids.Num() + Num);
+
+	for (int32 It = 0; It < Num; ++It)
+	{
+		if (AAFPS_Asteroid* Asteroid = SpawnAsteroid(AsteroidClass, FTransform::Identity))
+		{
+			Release(Asteroid);
+		}
+	}
+}
+
+AAFPS_Asteroid* UAFPS_AsteroidPoolComponent::Acquire(TSubclassOf<AAFPS_Asteroid> AsteroidClass, const FTransform& SpawnTransform)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AsteroidPoolAcquire);
+
+	// search from the end, usually there is only one asteroid class so it's the last one
+	for (int32 It = FreeAsteroids.Num() - 1; It >= 0; --It)
+	{
+		AAFPS_Asteroid* Asteroid = FreeAsteroids[It];
+		if (Asteroid == nullptr || Asteroid->IsPendingKill())
+		{
+			FreeAsteroids.RemoveAtSwap(It, 1, false);  // destroyed outside of pool
+			DEC_DWORD_STAT(STAT_AsteroidPoolFree);
+			continue;
+		}
+
+		if (Asteroid->GetClass() == AsteroidClass)
+		{
+			FreeAsteroids.RemoveAtSwap(It, 1, false);
+			Asteroid->OnAcquiredFromPool(SpawnTransform);
+
+			++PoolHits;
+			DEC_DWORD_STAT(STAT_AsteroidPoolFree);
+			INC_DWORD_STAT(STAT_AsteroidPoolHits);
+			return Asteroid;
+		}
+	}
+
+	++PoolMisses;
+	INC_DWORD_STAT(STAT_AsteroidPoolMisses);
+	return SpawnAsteroid(AsteroidClass, SpawnTransform);
+}
+
+void UAFPS_AsteroidPoolComponent::Release(AAFPS_Asteroid* Asteroid)
+{
+	if (Asteroid == nullptr || Asteroid->IsInPool())
+	{
+		return;
+	}
+
+	Asteroid->OnReleasedToPool();
+	FreeAsteroids.Add(Asteroid);
+	INC_DWORD_STAT(STAT_AsteroidPoolFree);
+}
+
+void UAFPS_AsteroidPoolComponent::DestroyFreeAsteroids()
+{
+	for (AAFPS_Asteroid* Asteroid : FreeAsteroids)
+	{
+		if (Asteroid && !Asteroid->IsPendingKill())
+		{
+			Asteroid->Destroy();
+		}
+	}
+
+	DEC_DWORD_STAT_BY(STAT_AsteroidPoolFree, FreeAsteroids.Num());
+	FreeAsteroids.Reset();
+}
+
+AAFPS_Asteroid* UAFPS_AsteroidPoolComponent::SpawnAsteroid(TSubclassOf<AAFPS_Asteroid> AsteroidClass, const FTransform& SpawnTransform)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	return GetWorld()->SpawnActor<AAFPS_Asteroid>(AsteroidClass, SpawnTransform, SpawnParams);
+}
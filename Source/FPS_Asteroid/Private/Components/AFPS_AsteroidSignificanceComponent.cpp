@@ -0,0 +1,161 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Components/AFPS_AsteroidSignificanceComponent.h"
+#include "Camera/PlayerCameraManager.h"
+#include "GameFramework/PlayerController.h"
+
+#include <FPS_Asteroid/FPS_Asteroid.h>
+#include <FPS_Asteroid/Public/AFPS_Asteroid.h>
+#include <FPS_Asteroid/Public/AFPS_GameMode.h>
+
+DECLARE_CYCLE_STAT(TEXT("Asteroid Significance Update"), STAT_AsteroidSignificanceUpdate, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Asteroid Significance High"), STAT_AsteroidSignificanceHigh, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Asteroid Significance Medium"), STAT_AsteroidSignificanceMedium, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Asteroid Significance Low"), STAT_AsteroidSignificanceLow, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Asteroid Significance Culled"), STAT_AsteroidSignificanceCulled, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Asteroid Death FX Skipped"), STAT_AsteroidDeathFXSkipped, STATGROUP_FPSAsteroid);
+
+// Sets default values for this component's properties
+UAFPS_AsteroidSignificanceComponent::UAFPS_AsteroidSignificanceComponent()
+{
+	// significance is ready before physics and asteroid spin
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.TickGroup = ETickingGroup::TG_PrePhysics;
+
+	HighDistance = 5'000.f;     // 50 m
+	MediumDistance = 30'000.f;  // 300 m
+	CullDistance = TRACE_DIST_MAX;
+	UpdateFrames = 8;
+	LowUpdateFrameInterval = 4;
+	CulledUpdateFrameInterval = 16;
+
+	HighDeathFXBudget = -1;
+	MediumDeathFXBudget = 4;
+	LowDeathFXBudget = 1;
+	CulledDeathFXBudget = 0;
+	FMemory::Memzero(DeathFXNum);
+
+	UpdateCursor = 0;
+	FMemory::Memzero(PendingBucketNum);
+	FMemory::Memzero(BucketNum);
+
+	UpdateSeconds = 0.0;
+	FullUpdateSeconds = 0.0;
+	SavedSeconds = 0.0;
+	LastFrameSavedSeconds = 0.0;
+}
+
+void UAFPS_AsteroidSignificanceComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AsteroidSignificanceUpdate);
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	// saved time is reported by users after significance tick
+	LastFrameSavedSeconds = SavedSeconds;
+	SavedSeconds = 0.0;
+
+	FMemory::Memzero(DeathFXNum);
+
+	AAFPS_GameMode* GM = Cast<AAFPS_GameMode>(GetOwner());
+	APlayerController* PC = GetWorld()->GetFirstPlayerController();
+	if (GM == nullptr || PC == nullptr || PC->PlayerCameraManager == nullptr)
+	{
+		return;
+	}
+
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	const FVector ViewLocation = PC->PlayerCameraManager->GetCameraLocation();
+	const FVector ViewDirection = PC->PlayerCameraManager->GetCameraRotation().Vector();
+
+	// view cone wide enough to cover screen corners
+	const float HalfFOV = FMath::DegreesToRadians(FMath::Min(PC->PlayerCameraManager->GetFOVAngle() * 0.5f * 1.3f, 89.f));
+	const float CosHalfFOV = FMath::Cos(HalfFOV);
+	const float SinHalfFOV = FMath::Sin(HalfFOV);
+
+	const float HighDistanceSq = FMath::Square(HighDistance);
+	const float MediumDistanceSq = FMath::Square(MediumDistance);
+	const float CullDistanceSq = FMath::Square(CullDistance);
+
+	const TArray<AAFPS_Asteroid*>& LiveAsteroids = GM->GetLiveAsteroids();
+	const int32 AsteroidNum = LiveAsteroids.Num();
+	const int32 SliceNum = FMath::DivideAndRoundUp(AsteroidNum, FMath::Max(UpdateFrames, 1));
+
+	for (int32 It = 0; It != SliceNum; ++It)
+	{
+		if (UpdateCursor >= AsteroidNum)
+		{
+			// update pass is complete
+			FMemory::Memcpy(BucketNum, PendingBucketNum, sizeof(BucketNum));
+			FMemory::Memzero(PendingBucketNum);
+			UpdateCursor = 0;
+		}
+
+		AAFPS_Asteroid* Asteroid = LiveAsteroids[UpdateCursor++];
+		if (Asteroid == nullptr)
+		{
+			continue;
+		}
+
+		const FVector ToAsteroid = Asteroid->GetActorLocation() - ViewLocation;
+		const float DistanceSq = ToAsteroid.SizeSquared();
+
+		EAsteroidSignificance Significance;
+		if (DistanceSq <= HighDistanceSq)
+		{
+			Significance = EAsteroidSignificance::High;
+		}
+		else if (DistanceSq > CullDistanceSq)
+		{
+			Significance = EAsteroidSignificance::Culled;
+		}
+		else
+		{
+			// sphere vs view cone, asteroid is in view if its bounding sphere touches cone
+			const float Radius = Asteroid->GetMesh()->Bounds.SphereRadius;
+			const float Along = FVector::DotProduct(ToAsteroid, ViewDirection);
+			const float Across = FMath::Sqrt(FMath::Max(DistanceSq - Along * Along, 0.f));
+			const bool bInView = Along * SinHalfFOV - Across * CosHalfFOV > -Radius && Along > -Radius;
+
+			Significance = bInView && DistanceSq <= MediumDistanceSq ? EAsteroidSignificance::Medium : EAsteroidSignificance::Low;
+		}
+
+		++PendingBucketNum[static_cast<uint8>(Significance)];
+
+		if (Asteroid->GetSignificance() != Significance)
+		{
+			// render visibility changes only on culled bucket enter/leave, wave asteroids stay visible at any distance
+			if ((Significance == EAsteroidSignificance::Culled) != (Asteroid->GetSignificance() == EAsteroidSignificance::Culled))
+			{
+				Asteroid->GetMesh()->SetVisibility(Significance != EAsteroidSignificance::Culled || Asteroid->GetSpawnedAsteroidIndex() != INDEX_NONE);
+			}
+			Asteroid->SetSignificance(Significance);
+		}
+	}
+
+	UpdateSeconds = FPlatformTime::Seconds() - StartSeconds;
+	FullUpdateSeconds = SliceNum ? UpdateSeconds * AsteroidNum / SliceNum : 0.0;
+
+	SET_DWORD_STAT(STAT_AsteroidSignificanceHigh, GetBucketNum(EAsteroidSignificance::High));
+	SET_DWORD_STAT(STAT_AsteroidSignificanceMedium, GetBucketNum(EAsteroidSignificance::Medium));
+	SET_DWORD_STAT(STAT_AsteroidSignificanceLow, GetBucketNum(EAsteroidSignificance::Low));
+	SET_DWORD_STAT(STAT_AsteroidSignificanceCulled, GetBucketNum(EAsteroidSignificance::Culled));
+}
+
+bool UAFPS_AsteroidSignificanceComponent::TryAddDeathFX(EAsteroidSignificance Significance)
+{
+	const int32 Budgets[] = { HighDeathFXBudget, MediumDeathFXBudget, LowDeathFXBudget, CulledDeathFXBudget };
+	static_assert(UE_ARRAY_COUNT(Budgets) == static_cast<uint8>(EAsteroidSignificance::MAX), "Death fx budget per significance");
+
+	const uint8 Bucket = static_cast<uint8>(Significance);
+	if (Budgets[Bucket] >= 0 && DeathFXNum[Bucket] >= Budgets[Bucket])
+	{
+		INC_DWORD_STAT(STAT_AsteroidDeathFXSkipped);
+		return false;
+	}
+
+	++DeathFXNum[Bucket];
+	return true;
+}
@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Components/AFPS_AsteroidSpinComponent.h"
+
+#include <FPS_Asteroid/FPS_Asteroid.h>
+#include <FPS_Asteroid/Public/AFPS_Asteroid.h>
+#include <FPS_Asteroid/Public/AFPS_GameMode.h>
+
+DECLARE_CYCLE_STAT(TEXT("Asteroid Spin Writeback"), STAT_AsteroidSpinWriteback, STATGROUP_FPSAsteroid);
+DECLARE_MEMORY_STAT(TEXT("Asteroid Spin Data"), STAT_AsteroidSpinMemory, STATGROUP_FPSAsteroid);
+
+// Sets default values for this component's properties
+UAFPS_AsteroidSpinComponent::UAFPS_AsteroidSpinComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+}
+
+void UAFPS_AsteroidSpinComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	AAFPS_GameMode* GM = Cast<AAFPS_GameMode>(GetOwner());
+	if (GM == nullptr || !Spin.Integrate(DeltaTime))
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_AsteroidSpinWriteback);
+
+	UAFPS_AsteroidSignificanceComponent* Significance = GM->GetAsteroidSignificance();
+
+	const double StartSeconds = FPlatformTime::Seconds();
+	int32 WrittenNum = 0;
+	int32 SkippedNum = 0;
+
+	// only spinning asteroids are moved, kinematic body follows component
+	const TArray<AAFPS_Asteroid*>& LiveAsteroids = GM->GetLiveAsteroids();
+	for (int32 It = 0, Num = Spin.Num(); It != Num; ++It)
+	{
+		AAFPS_Asteroid* Asteroid = LiveAsteroids[It];
+		if (!Spin.IsSpinning(It) || Asteroid == nullptr)
+		{
+			continue;
+		}
+
+		// not significant asteroids are rotated less often
+		if (Significance && !Significance->ShouldUpdateThisFrame(Asteroid->GetSignificance(), It))
+		{
+			++SkippedNum;
+			continue;
+		}
+
+		Asteroid->GetMesh()->SetWorldRotation(Spin.GetRotation(It), false, nullptr, ETeleportType::TeleportPhysics);
+		++WrittenNum;
+	}
+
+	if (Significance && WrittenNum)
+	{
+		Significance->AddSavedSeconds((FPlatformTime::Seconds() - StartSeconds) / WrittenNum * SkippedNum);
+	}
+}
+
+void UAFPS_AsteroidSpinComponent::AddAsteroid(AAFPS_Asteroid* Asteroid)
+{
+	const int32 Index = Spin.Add(Asteroid->GetActorQuat());
+	check(Index == Asteroid->GetLiveAsteroidIndex());
+
+	SET_MEMORY_STAT(STAT_AsteroidSpinMemory, Spin.GetAllocatedSize());
+}
+
+void UAFPS_AsteroidSpinComponent::RemoveAsteroidAtSwap(int32 LiveAsteroidIndex)
+{
+	Spin.RemoveAtSwap(LiveAsteroidIndex);
+}
+
+void UAFPS_AsteroidSpinComponent::AddImpulseAtLocation(AAFPS_Asteroid* Asteroid, const FVector& Impulse, const FVector& Location)
+{
+	const int32 Index = Asteroid->GetLiveAsteroidIndex();
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	// solid sphere inertia I = 2/5 * m * r^2, angular velocity change = (arm x impulse) / I
+	UStaticMeshComponent* MeshComp = Asteroid->GetMesh();
+	const float Radius = MeshComp->Bounds.SphereRadius;
+	const float Inertia = 0.4f * MeshComp->GetMass() * Radius * Radius;
+	if (Inertia > SMALL_NUMBER)
+	{
+		const FVector Arm = Location - Asteroid->GetActorLocation();
+		Spin.AddAngularVelocity(Index, FVector::CrossProduct(Arm, Impulse) / Inertia);
+	}
+}
@@ -0,0 +1,363 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Components/AFPS_BenchmarkComponent.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/FileHelper.h"
+
+#include <FPS_Asteroid/FPS_Asteroid.h>
+#include <FPS_Asteroid/Public/AFPS_Asteroid.h>
+#include <FPS_Asteroid/Public/AFPS_AsteroidField.h>
+#include <FPS_Asteroid/Public/AFPS_AsteroidSpawner.h>
+#include <FPS_Asteroid/Public/AFPS_GameMode.h>
+#include <FPS_Asteroid/Public/AFPS_HUD.h>
+#include <FPS_Asteroid/Public/Character/AFPS_Character.h>
+#include <FPS_Asteroid/Public/Character/AFPS_Weapon.h>
+
+void FAFPS_BenchmarkEndPhysicsTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target && !Target->IsPendingKill())
+	{
+		Target->OnEndPhysics();
+	}
+}
+
+FString FAFPS_BenchmarkEndPhysicsTickFunction::DiagnosticMessage()
+{
+	return TEXT("FAFPS_BenchmarkEndPhysicsTickFunction");
+}
+
+// Sets default values for this component's properties
+UAFPS_BenchmarkComponent::UAFPS_BenchmarkComponent()
+{
+	// component tick marks physics start, EndPhysicsTick marks physics end
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = ETickingGroup::TG_StartPhysics;
+
+	EndPhysicsTick.bCanEverTick = true;
+	EndPhysicsTick.bStartWithTickEnabled = false;
+	EndPhysicsTick.TickGroup = ETickingGroup::TG_EndPhysics;
+	EndPhysicsTick.Target = this;
+
+	KillInterval = 0.1f;
+	FireHoldSeconds = 1.f;
+	FireRestSeconds = 0.5f;
+	LastWaveFrames = 300;
+
+	bBenchmarkRequested = false;
+	WaveNum = 20;
+	Seed = 1;
+	MaxSeconds = 600.f;
+	ThresholdPercent = 10.f;
+	bRunning = false;
+}
+
+void UAFPS_BenchmarkComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	const TCHAR* CommandLine = FCommandLine::Get();
+	bBenchmarkRequested = FParse::Param(CommandLine, TEXT("AFPSBenchmark"));
+	if (!bBenchmarkRequested)
+	{
+		return;
+	}
+
+	OutDir = FPaths::ProjectSavedDir() / TEXT("Benchmark");
+
+	FParse::Value(CommandLine, TEXT("BenchmarkWaves="), WaveNum);
+	FParse::Value(CommandLine, TEXT("BenchmarkSeed="), Seed);
+	FParse::Value(CommandLine, TEXT("BenchmarkMaxSeconds="), MaxSeconds);
+	FParse::Value(CommandLine, TEXT("BenchmarkThreshold="), ThresholdPercent);
+	FParse::Value(CommandLine, TEXT("BenchmarkOut="), OutDir);
+	FParse::Value(CommandLine, TEXT("BenchmarkBaseline="), BaselinePath);
+
+	UE_LOG(LogTemp, Display, TEXT("[Benchmark] Started: %d waves, seed %d, output %s"), WaveNum, Seed, *OutDir);
+
+	KillStream.Initialize(Seed);
+	bRunning = true;
+	RunSeconds = 0.f;
+	NextKillSeconds = KillInterval;
+	FireStateSeconds = 0.f;
+	bFiring = false;
+	LastWaveFrameCount = 0;
+	PhysicsStartSeconds = 0.0;
+	LastPhysicsMs = 0.f;
+
+	Frames.Reset();
+	Frames.Reserve(60 * 60);
+
+	EndPhysicsTick.RegisterTickFunction(GetComponentLevel());
+	EndPhysicsTick.SetTickFunctionEnable(true);
+	SetComponentTickEnabled(true);
+}
+
+void UAFPS_BenchmarkComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (EndPhysicsTick.IsTickFunctionRegistered())
+	{
+		EndPhysicsTick.UnRegisterTickFunction();
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UAFPS_BenchmarkComponent::OnEndPhysics()
+{
+	LastPhysicsMs = static_cast<float>((FPlatformTime::Seconds() - PhysicsStartSeconds) * 1000.0);
+}
+
+void UAFPS_BenchmarkComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	AAFPS_GameMode* GM = Cast<AAFPS_GameMode>(GetOwner());
+	AAFPS_AsteroidSpawner* Spawner = GM ? GM->GetAsteroidSpawner() : nullptr;
+	if (!bRunning || Spawner == nullptr)
+	{
+		return;
+	}
+
+	// previous frame is complete here, physics time is measured from this tick to end physics tick
+	FAFPS_BenchmarkFrame& Frame = Frames.AddDefaulted_GetRef();
+	Frame.Wave = Spawner->GetWaveCount();
+	Frame.FrameMs = DeltaTime * 1000.f;
+	Frame.GameThreadMs = static_cast<float>(FPlatformTime::ToMilliseconds(GGameThreadTime));
+	Frame.PhysicsMs = LastPhysicsMs;
+	Frame.ActorNum = GetWorld()->GetActorCount();
+	Frame.LiveAsteroidNum = Spawner->GetAliveSpawnedAsteroidNum();
+	Frame.UsedPhysicalMemory = FPlatformMemory::GetStats().UsedPhysical;
+
+	// HUD draw cost is counted even with -nullrhi
+	APlayerController* PC = GetWorld()->GetFirstPlayerController();
+	AAFPS_HUD* HUD = PC ? PC->GetHUD<AAFPS_HUD>() : nullptr;
+	Frame.HUDDrawItemNum = HUD ? HUD->GetDrawBatch().GetDrawItemNum() : 0;
+	Frame.HUDQuadNum = HUD ? HUD->GetDrawBatch().GetQuadNum() : 0;
+
+	PhysicsStartSeconds = FPlatformTime::Seconds();
+	RunSeconds += DeltaTime;
+
+	// scripted kill policy, kill only spawned asteroids so waves keep going
+	if (RunSeconds >= NextKillSeconds && Spawner->GetPendingSpawnAsteroidNum() == 0)
+	{
+		NextKillSeconds = RunSeconds + KillInterval;
+		KillRandomAsteroid();
+	}
+
+	UpdateFirePattern(DeltaTime);
+
+	if (Spawner->GetWaveCount() >= WaveNum)
+	{
+		++LastWaveFrameCount;
+	}
+
+	if (LastWaveFrameCount >= LastWaveFrames || RunSeconds >= MaxSeconds)
+	{
+		FinishBenchmark();
+	}
+}
+
+void UAFPS_BenchmarkComponent::KillRandomAsteroid()
+{
+	AAFPS_GameMode* GM = Cast<AAFPS_GameMode>(GetOwner());
+	AAFPS_AsteroidSpawner* Spawner = GM->GetAsteroidSpawner();
+
+	if (AAFPS_AsteroidField* Field = Spawner->GetAsteroidField())
+	{
+		if (Field->GetAliveInstanceNum() == 0)
+		{
+			return;
+		}
+
+		// random alive instance, killed instances are reused so alive ones are dense enough
+		for (int32 Attempt = 0; Attempt != 32; ++Attempt)
+		{
+			const int32 InstanceIndex = KillStream.RandHelper(Field->GetInstanceNum());
+			if (Field->IsInstanceAlive(InstanceIndex))
+			{
+				Field->ApplyInstanceDamage(InstanceIndex, BIG_NUMBER, FVector::ForwardVector, Field->GetInstanceLocation(InstanceIndex), nullptr, nullptr);
+				return;
+			}
+		}
+		return;
+	}
+
+	const TArray<AAFPS_Asteroid*>& Asteroids = Spawner->GetAliveSpawnedAsteroids();
+	if (Asteroids.Num())
+	{
+		UGameplayStatics::ApplyDamage(Asteroids[KillStream.RandHelper(Asteroids.Num())], BIG_NUMBER, nullptr, nullptr, nullptr);
+	}
+}
+
+void UAFPS_BenchmarkComponent::UpdateFirePattern(float DeltaTime)
+{
+	AAFPS_Character* Character = Cast<AAFPS_Character>(UGameplayStatics::GetPlayerPawn(this, 0));
+	AAFPS_Weapon* Weapon = Character ? Character->GetWeaponInHands() : nullptr;
+	if (Weapon == nullptr)
+	{
+		return;
+	}
+
+	FireStateSeconds += DeltaTime;
+	if (bFiring && FireStateSeconds >= FireHoldSeconds)
+	{
+		Weapon->StopFire();
+		bFiring = false;
+		FireStateSeconds = 0.f;
+	}
+	else if (!bFiring && FireStateSeconds >= FireRestSeconds)
+	{
+		Weapon->StartFire();
+		bFiring = true;
+		FireStateSeconds = 0.f;
+	}
+}
+
+void UAFPS_BenchmarkComponent::FinishBenchmark()
+{
+	bRunning = false;
+	SetComponentTickEnabled(false);
+	EndPhysicsTick.SetTickFunctionEnable(false);
+
+	const FString CsvPath = OutDir / TEXT("Frames.csv");
+	const FString SummaryPath = OutDir / TEXT("Summary.json");
+
+	bool bFailed = !WriteFramesCsv(CsvPath);
+
+	const TSharedRef<FJsonObject> Summary = MakeSummary();
+
+	FString SummaryString;
+	FJsonSerializer::Serialize(Summary, TJsonWriterFactory<>::Create(&SummaryString));
+	bFailed |= !FFileHelper::SaveStringToFile(SummaryString, *SummaryPath);
+
+	UE_LOG(LogTemp, Display, TEXT("[Benchmark] Finished: %d frames, results in %s"), Frames.Num(), *OutDir);
+
+	// MaxSeconds timeout, last recorded wave is not the requested one
+	const int32 LastWave = static_cast<int32>(Summary->GetNumberField(TEXT("LastWave")));
+	if (LastWave < WaveNum)
+	{
+		UE_LOG(LogTemp, Error, TEXT("[Benchmark] Timeout: wave %d of %d reached in %.0f s"), LastWave, WaveNum, RunSeconds);
+		bFailed = true;
+	}
+
+	// last wave game thread time vs same wave of baseline
+	FString BaselineString;
+	if (!BaselinePath.IsEmpty() && FFileHelper::LoadFileToString(BaselineString, *BaselinePath))
+	{
+		TSharedPtr<FJsonObject> Baseline;
+		if (FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(BaselineString), Baseline) && Baseline.IsValid())
+		{
+			double BaselineMs = -1.0;
+			const TArray<TSharedPtr<FJsonValue>>* BaselineWaveValues;
+			if (Baseline->TryGetArrayField(TEXT("WaveStats"), BaselineWaveValues))
+			{
+				for (const TSharedPtr<FJsonValue>& WaveValue : *BaselineWaveValues)
+				{
+					const TSharedPtr<FJsonObject>* WaveObject;
+					if (WaveValue->TryGetObject(WaveObject) && static_cast<int32>((*WaveObject)->GetNumberField(TEXT("Wave"))) == LastWave)
+					{
+						BaselineMs = (*WaveObject)->GetNumberField(TEXT("AvgGameThreadMs"));
+						break;
+					}
+				}
+			}
+
+			const double CurrentMs = Summary->GetNumberField(TEXT("LastWaveGameThreadMs"));
+			const double SlowdownPercent = BaselineMs > 0.0 ? (CurrentMs / BaselineMs - 1.0) * 100.0 : 0.0;
+
+			if (BaselineMs < 0.0)
+			{
+				UE_LOG(LogTemp, Error, TEXT("[Benchmark] Baseline %s has no wave %d"), *BaselinePath, LastWave);
+				bFailed = true;
+			}
+			else if (SlowdownPercent > ThresholdPercent)
+			{
+				UE_LOG(LogTemp, Error, TEXT("[Benchmark] Regression: wave %d game thread %.3f ms, baseline %.3f ms (+%.1f%% > %.1f%%)"),
+					LastWave, CurrentMs, BaselineMs, SlowdownPercent, ThresholdPercent);
+				bFailed = true;
+			}
+			else
+			{
+				UE_LOG(LogTemp, Display, TEXT("[Benchmark] Wave %d game thread %.3f ms, baseline %.3f ms (%+.1f%%)"),
+					LastWave, CurrentMs, BaselineMs, SlowdownPercent);
+			}
+		}
+		else
+		{
+			UE_LOG(LogTemp, Error, TEXT("[Benchmark] Can't parse baseline %s"), *BaselinePath);
+			bFailed = true;
+		}
+	}
+
+	FPlatformMisc::RequestExitWithStatus(false, bFailed ? 1 : 0);
+}
+
+bool UAFPS_BenchmarkComponent::WriteFramesCsv(const FString& Path) const
+{
+	FString Csv = TEXT("Frame,Wave,FrameMs,GameThreadMs,PhysicsMs,ActorNum,LiveAsteroidNum,HUDDrawItems,HUDQuads,UsedPhysicalMB\n");
+	Csv.Reserve(Frames.Num() * 64);
+
+	for (int32 It = 0; It != Frames.Num(); ++It)
+	{
+		const FAFPS_BenchmarkFrame& Frame = Frames[It];
+		Csv += FString::Printf(TEXT("%d,%d,%.3f,%.3f,%.3f,%d,%d,%d,%d,%.1f\n"), It, Frame.Wave, Frame.FrameMs, Frame.GameThreadMs, Frame.PhysicsMs,
+			Frame.ActorNum, Frame.LiveAsteroidNum, Frame.HUDDrawItemNum, Frame.HUDQuadNum, Frame.UsedPhysicalMemory / (1024.0 * 1024.0));
+	}
+
+	return FFileHelper::SaveStringToFile(Csv, *Path);
+}
+
+TSharedRef<FJsonObject> UAFPS_BenchmarkComponent::MakeSummary() const
+{
+	TSharedRef<FJsonObject> Summary = MakeShared<FJsonObject>();
+	Summary->SetNumberField(TEXT("Seed"), Seed);
+	Summary->SetNumberField(TEXT("Waves"), WaveNum);
+	Summary->SetNumberField(TEXT("Frames"), Frames.Num());
+
+	TArray<TSharedPtr<FJsonValue>> WaveValues;
+	int32 LastWave = 0;
+	double LastWaveGameThreadMs = 0.0;
+
+	// frames are recorded in wave order
+	for (int32 First = 0; First < Frames.Num();)
+	{
+		const int32 Wave = Frames[First].Wave;
+
+		int32 End = First;
+		double FrameMs = 0.0, GameThreadMs = 0.0, PhysicsMs = 0.0, MaxFrameMs = 0.0;
+		for (; End < Frames.Num() && Frames[End].Wave == Wave; ++End)
+		{
+			FrameMs += Frames[End].FrameMs;
+			GameThreadMs += Frames[End].GameThreadMs;
+			PhysicsMs += Frames[End].PhysicsMs;
+			MaxFrameMs = FMath::Max<double>(MaxFrameMs, Frames[End].FrameMs);
+		}
+
+		const int32 FrameNum = End - First;
+
+		TSharedRef<FJsonObject> WaveObject = MakeShared<FJsonObject>();
+		WaveObject->SetNumberField(TEXT("Wave"), Wave);
+		WaveObject->SetNumberField(TEXT("Frames"), FrameNum);
+		WaveObject->SetNumberField(TEXT("AvgFrameMs"), FrameMs / FrameNum);
+		WaveObject->SetNumberField(TEXT("MaxFrameMs"), MaxFrameMs);
+		WaveObject->SetNumberField(TEXT("AvgGameThreadMs"), GameThreadMs / FrameNum);
+		WaveObject->SetNumberField(TEXT("AvgPhysicsMs"), PhysicsMs / FrameNum);
+		WaveObject->SetNumberField(TEXT("ActorNum"), Frames[End - 1].ActorNum);
+		WaveObject->SetNumberField(TEXT("LiveAsteroidNum"), Frames[End - 1].LiveAsteroidNum);
+		WaveValues.Add(MakeShared<FJsonValueObject>(WaveObject));
+
+		LastWave = Wave;
+		LastWaveGameThreadMs = GameThreadMs / FrameNum;
+		First = End;
+	}
+
+	Summary->SetArrayField(TEXT("WaveStats"), WaveValues);
+	Summary->SetNumberField(TEXT("LastWave"), LastWave);
+	Summary->SetNumberField(TEXT("LastWaveGameThreadMs"), LastWaveGameThreadMs);
+
+	return Summary;
+}
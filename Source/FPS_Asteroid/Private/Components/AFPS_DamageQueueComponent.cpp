@@ -0,0 +1,239 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Components/AFPS_DamageQueueComponent.h"
+#include "Components/AFPS_AsteroidSpinComponent.h"
+#include "Components/AFPS_HealthComponent.h"
+#include "AFPS_DamageQueueTestListener.h"
+#include "AFPS_Asteroid.h"
+#include "AFPS_GameMode.h"
+#include "GameFramework/DamageType.h"
+#include "Kismet/GameplayStatics.h"
+
+#include <FPS_Asteroid/FPS_Asteroid.h>
+
+DECLARE_CYCLE_STAT(TEXT("Damage Queue Resolve"), STAT_DamageQueueResolve, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Queue Hits"), STAT_DamageQueueHits, STATGROUP_FPSAsteroid);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Queue Victims"), STAT_DamageQueueVictims, STATGROUP_FPSAsteroid);
+
+static FAutoConsoleCommandWithWorldAndArgs DamageQueueTestCmd(
+	TEXT("AFPS.DamageQueue.Test"),
+	TEXT("Queue fixed hits on test actors, resolve them and check summed damage per (actor, item), single health change and kill per victim and skip of victims destroyed before and during resolve"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		AAFPS_GameMode* GM = World ? World->GetAuthGameMode<AAFPS_GameMode>() : nullptr;
+		if (GM == nullptr)
+		{
+			return;
+		}
+
+		// plain actors with Other kill category, so pool, live asteroid registry and ray caster are not touched
+		enum { Chip, Kill, Overkill, DestroyedBefore, DestroyedDuring, Items, TargetNum };
+		AActor* Targets[TargetNum] = {};
+		UAFPS_HealthComponent* Healths[TargetNum] = {};
+
+		UAFPS_DamageQueueTestListener* Listener = NewObject<UAFPS_DamageQueueTestListener>();
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		for (int32 It = 0; It != TargetNum; ++It)
+		{
+			Targets[It] = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(FVector(0.f, 0.f, -1'000'000'00.f)), SpawnParams);
+			if (Targets[It] == nullptr)
+			{
+				return;
+			}
+
+			// actor has begun play, so registration binds OnTakeAnyDamage
+			Healths[It] = NewObject<UAFPS_HealthComponent>(Targets[It]);
+			Healths[It]->RegisterComponent();
+			Healths[It]->OnHealthChanged.AddDynamic(Listener, &UAFPS_DamageQueueTestListener::OnHealthChanged);
+		}
+
+		TMap<const AActor*, int32> KillNums;
+		const FDelegateHandle KillHandle = GM->GetKillEventBus().OnAnyKill().AddLambda([&KillNums, &Targets](const FKillEvent& KillEvent)
+		{
+			++KillNums.FindOrAdd(KillEvent.Victim, 0);
+
+			// victim queued after Kill target is destroyed by its death
+			if (KillEvent.Victim == Targets[Kill])
+			{
+				Targets[DestroyedDuring]->Destroy();
+			}
+		});
+
+		UAFPS_DamageQueueComponent* DamageQueue = NewObject<UAFPS_DamageQueueComponent>(GM);
+
+		auto QueueHit = [DamageQueue, &Targets](int32 Target, float Damage, int32 Item = INDEX_NONE)
+		{
+			FHitResult Hit;
+			Hit.Item = Item;
+			DamageQueue->QueuePointDamage(Targets[Target], Damage, FVector::ForwardVector, Hit, nullptr, nullptr, UDamageType::StaticClass());
+		};
+
+		QueueHit(Chip, 10.f);
+		QueueHit(Kill, 60.f);
+		QueueHit(Items, 10.f, 0);
+		QueueHit(Chip, 10.f);
+		QueueHit(Overkill, 200.f);
+		QueueHit(Kill, 60.f);
+		QueueHit(DestroyedBefore, 50.f);
+		QueueHit(Items, 5.f, 1);
+		QueueHit(Overkill, 50.f);
+		QueueHit(DestroyedDuring, 50.f);
+		QueueHit(Items, 10.f, 0);
+		QueueHit(Chip, 10.f);
+
+		Targets[DestroyedBefore]->Destroy();
+
+		DamageQueue->ResolveQueuedDamage();
+
+		// expected health deltas and kills per target
+		const TArray<float> ExpectedDeltas[TargetNum] = { { 30.f }, { 120.f }, { 250.f }, {}, {}, { 20.f, 5.f } };
+		const int32 ExpectedKills[TargetNum] = { 0, 1, 1, 0, 0, 0 };
+
+		bool bPassed = DamageQueue->GetQueuedHitNum() == 0;
+		for (int32 It = 0; It != TargetNum; ++It)
+		{
+			const TArray<float>* Deltas = Listener->HealthDeltas.Find(Healths[It]);
+			const TArray<float> Actual = Deltas ? *Deltas : TArray<float>();
+			const int32 KillNum = KillNums.FindRef(Targets[It]);
+
+			const bool bTargetPassed = Actual == ExpectedDeltas[It] && KillNum == ExpectedKills[It];
+			bPassed &= bTargetPassed;
+
+			UE_LOG(LogTemp, Display, TEXT("[DamageQueue] target %d: %d health changes (first delta %.1f), %d kills %s"),
+				It, Actual.Num(), Actual.Num() ? Actual[0] : 0.f, KillNum, bTargetPassed ? TEXT("OK") : TEXT("MISMATCH"));
+		}
+
+		UE_LOG(LogTemp, Display, TEXT("[DamageQueue] Test %s"), bPassed ? TEXT("PASSED") : TEXT("FAILED"));
+
+		GM->GetKillEventBus().OnAnyKill().Remove(KillHandle);
+		for (AActor* Target : Targets)
+		{
+			if (!Target->IsPendingKillPending())
+			{
+				Target->Destroy();
+			}
+		}
+		DamageQueue->MarkPendingKill();
+		Listener->MarkPendingKill();
+	})
+);
+
+void UAFPS_DamageQueueTestListener::OnHealthChanged(UAFPS_HealthComponent* HealthComp, float Health, float HealthDelta, const UDamageType* DamageType,
+	AController* InstigatedBy, AActor* DamageCauser)
+{
+	HealthDeltas.FindOrAdd(HealthComp).Add(HealthDelta);
+}
+
+// Sets default values for this component's properties
+UAFPS_DamageQueueComponent::UAFPS_DamageQueueComponent()
+{
+	// resolve damage after timers and weapons are ticked
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.TickGroup = ETickingGroup::TG_PostUpdateWork;
+}
+
+void UAFPS_DamageQueueComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (QueuedHits.Num())
+	{
+		ResolveQueuedDamage();
+	}
+}
+
+void UAFPS_DamageQueueComponent::QueuePointDamage(AActor* DamagedActor, float BaseDamage, const FVector& HitFromDirection, const FHitResult& HitInfo,
+	AController* EventInstigator, AActor* DamageCauser, TSubclassOf<UDamageType> DamageTypeClass)
+{
+	if (DamagedActor && BaseDamage != 0.f)
+	{
+		QueuedHits.Add({ DamagedActor, BaseDamage, HitFromDirection, HitInfo, EventInstigator, DamageCauser, DamageTypeClass });
+	}
+}
+
+void UAFPS_DamageQueueComponent::ResolveQueuedDamage()
+{
+	SCOPE_CYCLE_COUNTER(STAT_DamageQueueResolve);
+
+	Swap(QueuedHits, ResolvingHits);
+
+	TargetIndices.Reset();
+	TargetLastHit.Reset();
+	TargetDamage.Reset();
+	HitTargets.Reset(ResolvingHits.Num());
+
+	// aggregate hits by target, instanced targets (e.g. asteroid field) are aggregated by hit item
+	for (int32 HitIndex = 0, HitNum = ResolvingHits.Num(); HitIndex != HitNum; ++HitIndex)
+	{
+		const FQueuedPointDamage& QueuedHit = ResolvingHits[HitIndex];
+		AActor* Target = QueuedHit.Target.Get();
+		if (Target == nullptr || Target->IsPendingKillPending())
+		{
+			HitTargets.Add(INDEX_NONE);
+			continue;  // destroyed since hit was queued
+		}
+
+		int32& TargetIndex = TargetIndices.FindOrAdd(TPair<AActor*, int32>(Target, QueuedHit.Hit.Item), INDEX_NONE);
+		if (TargetIndex == INDEX_NONE)
+		{
+			TargetIndex = TargetDamage.Add(0.f);
+			TargetLastHit.Add(HitIndex);
+		}
+
+		TargetDamage[TargetIndex] += QueuedHit.Damage;
+		TargetLastHit[TargetIndex] = HitIndex;
+		HitTargets.Add(TargetIndex);
+	}
+
+	AAFPS_GameMode* GM = Cast<AAFPS_GameMode>(GetOwner());
+	UAFPS_AsteroidSpinComponent* AsteroidSpin = GM ? GM->GetAsteroidSpin() : nullptr;
+
+	// every hit pushes target like UPrimitiveComponent::ReceiveComponentDamage does,
+	// last hit impulse is applied by TakeDamage below (engine for simulated body, asteroid for analytic spin)
+	for (int32 HitIndex = 0, HitNum = ResolvingHits.Num(); HitIndex != HitNum; ++HitIndex)
+	{
+		if (HitTargets[HitIndex] == INDEX_NONE || TargetLastHit[HitTargets[HitIndex]] == HitIndex)
+		{
+			continue;
+		}
+
+		const FQueuedPointDamage& QueuedHit = ResolvingHits[HitIndex];
+		const UDamageType* DamageTypeCDO = QueuedHit.DamageType ? QueuedHit.DamageType->GetDefaultObject<UDamageType>() : GetDefault<UDamageType>();
+
+		UPrimitiveComponent* HitComponent = QueuedHit.Hit.GetComponent();
+		if (HitComponent && HitComponent->IsSimulatingPhysics(QueuedHit.Hit.BoneName))
+		{
+			HitComponent->AddImpulseAtLocation(QueuedHit.ShotDirection * DamageTypeCDO->DamageImpulse, QueuedHit.Hit.ImpactPoint, QueuedHit.Hit.BoneName);
+		}
+		else if (AAFPS_Asteroid* Asteroid = AsteroidSpin ? Cast<AAFPS_Asteroid>(QueuedHit.Target.Get()) : nullptr)
+		{
+			// not simulated asteroid is spun by game mode
+			AsteroidSpin->AddImpulseAtLocation(Asteroid, QueuedHit.ShotDirection * DamageTypeCDO->DamageImpulse, QueuedHit.Hit.ImpactPoint);
+		}
+	}
+
+	const int32 TargetNum = TargetDamage.Num();
+
+	// single TakeDamage per victim with summed damage, so OnTakeAnyDamage/OnTakePointDamage listeners still fire
+	for (int32 It = 0; It != TargetNum; ++It)
+	{
+		const FQueuedPointDamage& LastHit = ResolvingHits[TargetLastHit[It]];
+
+		// victim may be destroyed by previous victim death
+		AActor* Target = LastHit.Target.Get();
+		if (Target == nullptr || Target->IsPendingKillPending())
+		{
+			continue;
+		}
+
+		UGameplayStatics::ApplyPointDamage(Target, TargetDamage[It], LastHit.ShotDirection, LastHit.Hit, LastHit.InstigatedBy.Get(), LastHit.DamageCauser.Get(), LastHit.DamageType);
+	}
+
+	SET_DWORD_STAT(STAT_DamageQueueHits, ResolvingHits.Num());
+	SET_DWORD_STAT(STAT_DamageQueueVictims, TargetNum);
+
+	ResolvingHits.Reset();
+}
@@ -0,0 +1,25 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "AFPS_DamageQueueTestListener.generated.h"
+
+class UAFPS_HealthComponent;
+
+/**
+ * Health changed subscriber of AFPS.DamageQueue.Test, records every health delta per health component
+ */
+UCLASS(Transient)
+class UAFPS_DamageQueueTestListener : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	TMap<const UAFPS_HealthComponent*, TArray<float>> HealthDeltas;
+
+	UFUNCTION()
+	void OnHealthChanged(UAFPS_HealthComponent* HealthComp, float Health, float HealthDelta, const class UDamageType* DamageType,
+		class AController* InstigatedBy, AActor* DamageCauser);
+};
@@ -0,0 +1,10 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Components/AFPS_DummyHealthComponent.h"
+
+// Sets default values for this component's properties
+UAFPS_DummyHealthComponent::UAFPS_DummyHealthComponent()
+{
+	SetKillCategory(EKillVictimCategory::Dummy);
+}
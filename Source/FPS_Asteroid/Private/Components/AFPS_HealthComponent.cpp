@@ -5,12 +5,16 @@
 #include "GameFramework/Actor.h"
 
 #include <FPS_Asteroid/Public/AFPS_GameMode.h>
+#include <FPS_Asteroid/Public/AFPS_ScopeStats.h>
+
+AFPS_DECLARE_SCOPE_STAT("Health Take Any Damage", HealthTakeAnyDamage);
 
 // Sets default values for this component's properties
 UAFPS_HealthComponent::UAFPS_HealthComponent()
 {
 	// defaults
 	DefaultHealth = 100.f;
+	KillCategory = EKillVictimCategory::Other;
 }
 
 void UAFPS_HealthComponent::BeginPlay()
@@ -30,6 +34,7 @@ void UAFPS_HealthComponent::BeginPlay()
 void UAFPS_HealthComponent::HandleTakeAnyDamage(AActor* DamagedActor, float Damage,
 	const UDamageType* DamageType, AController* InstigatedBy, AActor* DamageCauser)
 {
+	AFPS_SCOPE_STAT(HealthTakeAnyDamage);
 
 	if (Damage <= 0.0f || bIsDead)
 	{
@@ -47,8 +52,26 @@ void UAFPS_HealthComponent::HandleTakeAnyDamage(AActor* DamagedActor, float Dama
 	{
 		if (AAFPS_GameMode* GM = GetWorld()->GetAuthGameMode<AAFPS_GameMode>())
 		{
-			GM->NotifyActorKilled.Broadcast(GetOwner(), DamageCauser, InstigatedBy);
+			FKillEvent KillEvent;
+			KillEvent.Victim = GetOwner();
+			KillEvent.Killer = DamageCauser;
+			KillEvent.KillerController = InstigatedBy;
+			KillEvent.Category = KillCategory;
+
+			GM->GetKillEventBus().Broadcast(KillEvent);
+
+			// blueprint listeners
+			if (GM->NotifyActorKilled.IsBound())
+			{
+				GM->NotifyActorKilled.Broadcast(GetOwner(), DamageCauser, InstigatedBy);
+			}
 		}
 	}
 
 }
+
+void UAFPS_HealthComponent::ResetHealth()
+{
+	Health = DefaultHealth;
+	bIsDead = false;
+}
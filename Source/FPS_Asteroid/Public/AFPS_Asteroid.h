@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "Components/AFPS_AsteroidSignificanceComponent.h"
 #include "AFPS_Asteroid.generated.h"
 
 class UAFPS_HealthComponent;
@@ -26,16 +27,80 @@ class FPS_ASTEROID_API AAFPS_Asteroid : public AActor
 	bool bDrawDebugAsteroid;
 	#endif  // WITH_EDITORONLY_DATA
 
+	/** True if asteroid is deactivated and stored in asteroid pool */
+	bool bInPool;
+
+	/** True while OnAsteroidDeath event is running, blueprint destroy is deferred to FinishDeath then */
+	bool bDying;
+
+	/** Index in game mode live asteroids registry, INDEX_NONE if not registered */
+	int32 LiveAsteroidIndex;
+
+	/** Index in asteroid spawner spawned asteroids, INDEX_NONE if not spawned by spawner */
+	int32 SpawnedAsteroidIndex;
+
+	/** World time of last damage or spawn, used by physics LOD to put idle body to sleep */
+	float LastHitTime;
+
+	/** Relevance for player, updated by game mode significance component */
+	EAsteroidSignificance Significance;
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	// Called when actor is destroyed or level is unloaded
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:	
 	// Sets default values for this actor's properties
 	AAFPS_Asteroid();
 
+	/** Analytic spin gets point damage impulse here, simulated body gets it from engine ReceiveComponentDamage */
+	virtual float TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser) override;
+
 	/** On Health component changing health callback */
 	UFUNCTION()
 	void OnHealthChanged(UAFPS_HealthComponent* InHealthComp, float Health, float HealthDelta, 
 		const class UDamageType* DamageType, class AController* InstigatedBy, AActor* DamageCauser);
 
-	/** This is blueprint event to handle asteroid death fx and destory after */
+	/** This is blueprint event to handle asteroid death fx, asteroid is returned to game mode asteroid pool or destroyed after it, skipped over significance death fx budget */
 	UFUNCTION(BlueprintNativeEvent)
 	void OnAsteroidDeath();
+
+	/** Blueprint destroy is ignored while OnAsteroidDeath is running and asteroid pool is used, FinishDeath releases asteroid instead */
+	virtual void K2_DestroyActor() override;
+
+	/** Native step after OnAsteroidDeath event, returns asteroid to pool or destroys it */
+	void FinishDeath();
+
+	/** Hide asteroid, disable collision and physics, called from asteroid pool */
+	void OnReleasedToPool();
+
+	/** Move asteroid to SpawnTransform, reset health and enable it back, called from asteroid pool */
+	void OnAcquiredFromPool(const FTransform& SpawnTransform);
+
+	/** Get asteroid mesh */
+	FORCEINLINE UStaticMeshComponent* GetMesh() const { return MeshComp; }
+
+	/** Get world time of last damage or spawn */
+	FORCEINLINE float GetLastHitTime() const { return LastHitTime; }
+
+	/** Get relevance for player, can be used to scale asteroid fx */
+	UFUNCTION(BlueprintPure, BlueprintCallable, Category = "Asteroid")
+	FORCEINLINE EAsteroidSignificance GetSignificance() const { return Significance; }
+
+	/** Relevance for player, should be changed only by significance component */
+	FORCEINLINE void SetSignificance(EAsteroidSignificance InSignificance) { Significance = InSignificance; }
+
+	/** Check if asteroid is deactivated and stored in asteroid pool */
+	FORCEINLINE bool IsInPool() const { return bInPool; }
+
+	/** Live asteroids registry index, should be changed only by game mode */
+	FORCEINLINE int32 GetLiveAsteroidIndex() const { return LiveAsteroidIndex; }
+	FORCEINLINE void SetLiveAsteroidIndex(int32 Index) { LiveAsteroidIndex = Index; }
+
+	/** Spawned asteroids index, should be changed only by asteroid spawner */
+	FORCEINLINE int32 GetSpawnedAsteroidIndex() const { return SpawnedAsteroidIndex; }
+	FORCEINLINE void SetSpawnedAsteroidIndex(int32 Index) { SpawnedAsteroidIndex = Index; }
 };
@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "AFPS_AsteroidSpinSystem.h"
+#include "AFPS_AsteroidField.generated.h"
+
+class UHierarchicalInstancedStaticMeshComponent;
+
+/**
+ * Alternative to AAFPS_Asteroid actors, all field asteroids are instances of single hierarchical instanced mesh
+ * per instance health, scale and spin are stored in flat arrays, killed instances are hidden and reused
+ */
+UCLASS()
+class FPS_ASTEROID_API AAFPS_AsteroidField : public AActor
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Category = Components, VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+	UHierarchicalInstancedStaticMeshComponent* InstancesComp;
+
+	/** Instance health on spawn */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AsteroidField", meta = (AllowPrivateAccess = "true"))
+	float DefaultHealth;
+
+	/** Instance angular velocity gained per damage point, degrees per second */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AsteroidField", meta = (AllowPrivateAccess = "true"))
+	float HitSpinPerDamage;
+
+	/** Per instance data, indexed by instance index */
+	TArray<float> InstanceHealth;
+	TArray<float> InstanceScale;
+	TArray<FVector> InstanceLocation;
+
+	/** Per instance rotation and angular velocity (radians per second, world space), indexed by instance index */
+	FAsteroidSpinSystem InstanceSpin;
+
+	/** Killed instances indices, reused on next AddAsteroid */
+	TArray<int32> FreeInstances;
+
+	/** Alive instances num */
+	int32 AliveInstanceNum;
+
+	/** Transforms buffer for batched instances update */
+	TArray<FTransform> TransformsBuffer;
+
+	/** Update spinning instances transforms, contiguous spinning instances are updated by single batch */
+	void UpdateSpinningInstancesTransforms();
+
+public:
+	// Sets default values for this actor's properties
+	AAFPS_AsteroidField();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Resolve point damage to instance index from hit result */
+	virtual float TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser) override;
+
+	/** Add asteroid instance, reuse killed instance if possible, returns instance index */
+	int32 AddAsteroid(const FTransform& SpawnTransform);
+
+	/** Apply damage to instance, kill it when health is zero and notify game mode kill event bus */
+	void ApplyInstanceDamage(int32 InstanceIndex, float Damage, const FVector& ShotDirection, const FVector& HitLocation, AController* InstigatedBy, AActor* DamageCauser);
+
+	/** Check if instance index is alive asteroid */
+	FORCEINLINE bool IsInstanceAlive(int32 InstanceIndex) const { return InstanceHealth.IsValidIndex(InstanceIndex) && InstanceHealth[InstanceIndex] > 0.f; }
+
+	/** Get instance location, instances are not moving */
+	FORCEINLINE const FVector& GetInstanceLocation(int32 InstanceIndex) const { return InstanceLocation[InstanceIndex]; }
+
+	/** Get rotation independent instance bounding sphere radius */
+	float GetInstanceRadius(int32 InstanceIndex) const;
+
+	/** Get instances num, including killed ones */
+	FORCEINLINE int32 GetInstanceNum() const { return InstanceHealth.Num(); }
+
+	/** Get alive instances num */
+	UFUNCTION(BlueprintPure, BlueprintCallable)
+	FORCEINLINE int32 GetAliveInstanceNum() const { return AliveInstanceNum; }
+
+	/** Get instanced mesh */
+	FORCEINLINE UHierarchicalInstancedStaticMeshComponent* GetInstancesComp() const { return InstancesComp; }
+
+	/** Per instance data memory, for stats */
+	SIZE_T GetInstanceDataAllocatedSize() const;
+
+private:
+	/** Hide killed instance and free it for reuse */
+	void KillInstance(int32 InstanceIndex);
+};
@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Single ray vs sphere hit */
+struct FAsteroidRayHit
+{
+	/** Sphere index, as returned by FAsteroidRayCaster::AddSphere */
+	int32 SphereIndex;
+
+	/** Distance from ray origin to sphere entry point, 0 if origin is inside sphere */
+	float Distance;
+};
+
+/**
+ * Ray vs sphere set query, has no world dependencies
+ * spheres are stored in bounding volume hierarchy, each leaf keeps up to 4 spheres as structure of arrays
+ * so single leaf is tested by vector registers at once
+ * spheres added after Build() are tested linearly, removed spheres are only disabled, until next Build()
+ */
+struct FPS_ASTEROID_API FAsteroidRayCaster
+{
+	/** Remove all spheres and hierarchy */
+	void Reset();
+
+	/** Add sphere, it's tested linearly until next Build(), returns sphere index */
+	int32 AddSphere(const FVector& Center, float Radius);
+
+	/** Disable sphere, hierarchy bounds stay as they are until next Build() */
+	void RemoveSphere(int32 SphereIndex);
+
+	/** Build hierarchy for added and not removed spheres, sphere indices are kept */
+	void Build();
+
+	/**
+	 * Find all spheres intersected by ray
+	 * @param Origin ray origin
+	 * @param Direction normalized ray direction
+	 * @param MaxDistance max ray length
+	 * @param OutHits hits sorted by distance
+	 * @return hits num
+	 */
+	int32 Raycast(const FVector& Origin, const FVector& Direction, float MaxDistance, TArray<FAsteroidRayHit>& OutHits) const;
+
+	/** Get added spheres num */
+	FORCEINLINE int32 Num() const { return Centers.Num(); }
+
+	/** Check if hierarchy is built for all added spheres */
+	FORCEINLINE bool IsBuilt() const { return IndexedNum == Centers.Num(); }
+
+	/** Get spheres num added after Build(), tested linearly */
+	FORCEINLINE int32 GetUnindexedNum() const { return Centers.Num() - IndexedNum; }
+
+	/** Get removed spheres num, they are kept in hierarchy until next Build() */
+	FORCEINLINE int32 GetRemovedNum() const { return RemovedNum; }
+
+	/** Get allocated memory, for stats */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	/** Max spheres in leaf, leaf spheres are tested at once */
+	static constexpr int32 LeafSize = 4;
+
+	/** Hierarchy node, internal node children are ChildOrFirst and ChildOrFirst + 1 */
+	struct FNode
+	{
+		FVector Min;
+		FVector Max;
+		int32 ChildOrFirst;  // first child node for internal node, first leaf slot for leaf
+		bool bLeaf;
+	};
+
+	/** Split spheres range and add nodes recursively */
+	void BuildNode(int32 NodeIndex, int32 First, int32 Count);
+
+	/** Added spheres, removed sphere has negative radius */
+	TArray<FVector> Centers;
+	TArray<float> Radii;
+
+	/** Sphere index -> leaf slot, INDEX_NONE if sphere is not in hierarchy */
+	TArray<int32> SphereSlots;
+
+	/** Spheres order while building */
+	TArray<int32> BuildOrder;
+
+	TArray<FNode> Nodes;
+
+	/** Leaf slots, LeafSize per leaf, unused slots have negative RadiusSq */
+	TArray<float> SlotX;
+	TArray<float> SlotY;
+	TArray<float> SlotZ;
+	TArray<float> SlotRadiusSq;
+	TArray<int32> SlotSphere;
+
+	/** Spheres num when hierarchy was built, next spheres are tested linearly */
+	int32 IndexedNum = 0;
+
+	int32 RemovedNum = 0;
+};
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Uniform spatial hash of asteroid spawn points
+ * Cell size is equal to min allowed distance between asteroids, so any point closer then
+ * that distance is always located in one of 27 neighbour cells of tested point
+ */
+struct FPS_ASTEROID_API FAsteroidSpawnGrid
+{
+	/** Drop all points and set new cell size (usually SpawnParam.MinSpawnDistanceBetweenAsteroids) */
+	void Reset(float InCellSize);
+
+	/** Add spawn point to grid */
+	void Add(const FVector& Point);
+
+	/** Remove closest to InPoint stored point from InPoint neighbour cells, return false if nothing found */
+	bool Remove(const FVector& InPoint);
+
+	/** Check if there is no stored point closer then MinDistance to InPoint, MinDistance should be <= CellSize */
+	bool IsPointFree(const FVector& InPoint, float MinDistance) const;
+
+	/** Stored points number */
+	FORCEINLINE int32 Num() const { return PointNum; }
+
+	/** Grid cell size */
+	FORCEINLINE float GetCellSize() const { return CellSize; }
+
+	/** Cells and points memory, for stats */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	FORCEINLINE FIntVector GetCell(const FVector& Point) const
+	{
+		return FIntVector(
+			FMath::FloorToInt(Point.X * InvCellSize),
+			FMath::FloorToInt(Point.Y * InvCellSize),
+			FMath::FloorToInt(Point.Z * InvCellSize)
+		);
+	}
+
+	/** points stored per cell, cells without points are removed */
+	TMap<FIntVector, TArray<FVector>> Cells;
+
+	float CellSize = 1.f;
+	float InvCellSize = 1.f;
+
+	int32 PointNum = 0;
+};
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Contiguous structure of arrays points buffer, allows to process points 4 at once
+ */
+struct FPS_ASTEROID_API FSpherePointsSoA
+{
+	TArray<float> X;
+	TArray<float> Y;
+	TArray<float> Z;
+
+	void SetNumUninitialized(int32 NewNum)
+	{
+		X.SetNumUninitialized(NewNum, false);
+		Y.SetNumUninitialized(NewNum, false);
+		Z.SetNumUninitialized(NewNum, false);
+	}
+
+	FORCEINLINE int32 Num() const { return X.Num(); }
+
+	FORCEINLINE FVector GetPoint(int32 Index) const { return FVector(X[Index], Y[Index], Z[Index]); }
+};
+
+/**
+ * Batch asteroid spawn points sampler, has no world dependencies
+ */
+struct FPS_ASTEROID_API FAsteroidSpawnSampler
+{
+	/**
+	 * Generate area uniform points on unit sphere (Archimedes method: uniform Z and uniform azimuth)
+	 * random numbers are generated first, then sphere points are calculated by vector registers
+	 *
+	 * @param NumPoints points number to generate
+	 * @param Stream random stream to use
+	 * @param OutPoints unit sphere points
+	 */
+	static void UniformSpherePoints(int32 NumPoints, FRandomStream& Stream, FSpherePointsSoA& OutPoints);
+
+	/**
+	 * Bridson poisson disk sampling on sphere surface https://www.cs.ubc.ca/~rbridson/docs/bridson-siggraph07-poissondisk.pdf
+	 * Each accepted point is at least MinDistance away from other sampled points,
+	 * candidates are generated on sphere in [MinDistance, 2 * MinDistance] arc distance from active points.
+	 * Uniform seed point is tried before each growth step, so few points are spread over whole sphere instead of
+	 * growing single patch around first seed, growth fills space between seeds once sphere gets dense.
+	 * Result depends only on input params and Stream state.
+	 *
+	 * @param Origin sphere center
+	 * @param Radius sphere radius
+	 * @param MinDistance min distance between sampled points
+	 * @param NumPoints points number to sample
+	 * @param CandidatesNum candidates number to try around each active point before deactivating it, limits total work
+	 * @param Stream random stream to use
+	 * @param IsPointAllowed extra point check, e.g. test against already spawned asteroids
+	 * @param OutPoints sampled points
+	 * @return sampled points number, less then NumPoints if sphere has no more free space
+	 */
+	static int32 PoissonDiskSphere(const FVector& Origin, float Radius, float MinDistance, int32 NumPoints, int32 CandidatesNum,
+		FRandomStream& Stream, TFunctionRef<bool(const FVector&)> IsPointAllowed, TArray<FVector>& OutPoints);
+};
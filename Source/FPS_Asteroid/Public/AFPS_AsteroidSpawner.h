@@ -4,13 +4,18 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "AFPS_AsteroidSpawnGrid.h"
+#include "AFPS_KillEventBus.h"
+#include "AFPS_DebugTextBuilder.h"
 #include "AFPS_AsteroidSpawner.generated.h"
 
 extern TAutoConsoleVariable<bool> CVarDrawDebugAsteroidSpawner;
 
 class AAFPS_Asteroid;
+class AAFPS_AsteroidField;
 class AAFPS_GameMode;
 
+// Asteroid is nullptr when asteroid is spawned as instanced asteroid field instance
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnAsteroidSpawned, AAFPS_Asteroid*, Asteroid);
 
 /**
@@ -25,6 +30,14 @@ struct FAsteroidSpawnerParam
 	UPROPERTY(EditDefaultsOnly)
 	TSubclassOf<AAFPS_Asteroid> AsteroidClass;
 
+	/** Spawn asteroids as instances of single instanced mesh asteroid field instead of AsteroidClass actors */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	bool bUseInstancedAsteroidField;
+
+	/** Asteroid field class to spawn when bUseInstancedAsteroidField is true */
+	UPROPERTY(EditDefaultsOnly, meta = (EditCondition = "bUseInstancedAsteroidField"))
+	TSubclassOf<AAFPS_AsteroidField> AsteroidFieldClass;
+
 
 	/** Distance from SpawnOrigin to spawn asteroid on first wave */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
@@ -55,7 +68,7 @@ struct FAsteroidSpawnerParam
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
 	float MinSpawnDistanceBetweenAsteroids;
 
-	/** Max attempts to adsjust sphere spawn position 
+	/** Max candidates to try around each sampled spawn position
 	 * to make sure it's at least at MinSpawnDistanceBetweenAsteroids from other spawned asteroids
 	 */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
@@ -73,6 +86,33 @@ struct FAsteroidSpawnerParam
 	/** Limit asteroid scale, will be min(step+scale, abs_limit) if step is positive and max(step+scale, abs_limit) is negative */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
 	float AsteroidScaleLimit;
+
+
+	/** Wave asteroids are spawned over several frames, spend at most this milliseconds per frame on spawning (at least one asteroid per frame is spawned) */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (ClampMin = 0.0f))
+	float SpawnBudgetMsPerFrame;
+
+
+	/** Waves random seed, each wave has own random stream derived from seed and wave number, 0 - new seed on each play */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	int32 RandomSeed;
+
+	/** Don't check wave spawn points against asteroids of previous waves, 
+	 * so wave spawn transforms depend only on seed, wave number and spawn origin and can be replayed
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	bool bReplayableWaves;
+};
+
+/**
+ * Queued asteroid spawn, wave transforms are calculated at once and spawned in budget
+ */
+struct FPendingAsteroidSpawn
+{
+	FTransform Transform;
+
+	/** time when spawn was queued, used for spawn latency stat */
+	double QueueTime;
 };
 
 UCLASS()
@@ -108,10 +148,31 @@ class FPS_ASTEROID_API AAFPS_AsteroidSpawner : public AActor
 	UPROPERTY(BlueprintReadOnly, Category = "AsteroidSpawner", meta = (AllowPrivateAccess = "true"))
 	float AsteroidScale;
 
-	/** Store spawned asteroids to be able to calculate correct positions for next astroid spawn */
+	/** Store alive spawned asteroids, each asteroid stores own index to be swap removed */
 	UPROPERTY(BlueprintReadOnly, Category = "AsteroidSpawner", meta = (AllowPrivateAccess = "true"))
 	TArray<AAFPS_Asteroid*> SpawnedAsteroids;
 
+	/** Instanced asteroids, valid only if SpawnParam.bUseInstancedAsteroidField is true */
+	UPROPERTY(BlueprintReadOnly, Category = "AsteroidSpawner", meta = (AllowPrivateAccess = "true"))
+	AAFPS_AsteroidField* AsteroidField;
+
+	/** Game mode, spawner is prepared by */
+	UPROPERTY()
+	AAFPS_GameMode* GameMode;
+
+	/** Spatial hash of spawned asteroids locations, used to check spawn points against neighbour cells only */
+	FAsteroidSpawnGrid SpawnGrid;
+
+	/** Waves random seed, SpawnParam.RandomSeed or generated on first wave */
+	UPROPERTY(BlueprintReadOnly, Category = "AsteroidSpawner", meta = (AllowPrivateAccess = "true"))
+	int32 WavesSeed;
+
+	/** Queued asteroid spawns, spawned in Tick in SpawnParam.SpawnBudgetMsPerFrame budget */
+	TArray<FPendingAsteroidSpawn> PendingSpawns;
+
+	/** First not yet spawned PendingSpawns index */
+	int32 PendingSpawnIndex;
+
 public:	
 	// Sets default values for this actor's properties
 	AAFPS_AsteroidSpawner();
@@ -119,48 +180,86 @@ public:
 	// Called from game mode in onStartPlay()
 	void PrepareFirstWave(AAFPS_GameMode* GM);
 
+	/** Override SpawnParam.RandomSeed, should be called before PrepareFirstWave */
+	FORCEINLINE void SetRandomSeed(int32 Seed) { SpawnParam.RandomSeed = Seed; }
+
+	virtual void Tick(float DeltaSeconds) override;
+
 	#if WITH_EDITOR
 	void DrawDebug(float DeltaSeconds);
-	virtual void Tick(float DeltaSeconds) override;
+
+	/** Draw debug params text, kept between frames */
+	FDebugTextBuilder DebugText;
 	#endif  // WITH_EDITOR
 
 private:
 	/** flag to block SpawnWave() when it's inappropriate */
 	bool bAllowStartWave;
 
-	/** check if existing Asteroids ammount is not exceeds SpawnParam.SpawnedAsteroidLimitMax */
+	/** check if existing Asteroids ammount (game mode live asteroids + field asteroids + queued asteroids) is not exceeds SpawnParam.SpawnedAsteroidLimitMax */
 	bool CanSpawnWave();
 
 	/** proceed next wave spawn */
 	void StartNextWave();
 
-	/** Asteroids wave spawning */
+	/** Asteroids wave spawning, calculate wave transforms and queue asteroid spawns */
 	void StartWave();
 
-	/** Calculate next random asteroid spawn point offset from sphere with anchor=SpawnOrigin, radius=SpawnRadius*/
-	FORCEINLINE FVector CalcAsteroidSpawnPointOffset();
+	/** Spawn queued asteroids in SpawnParam.SpawnBudgetMsPerFrame budget */
+	void ProcessSpawnQueue();
+
+	/** Calculate wave spawn radius, asteroids num and first asteroid scale, depends only on wave number */
+	void CalcWaveState(int32 Wave, float& OutSpawnRadius, int32& OutAsteroidSpawnNum, float& OutAsteroidScale) const;
+
+	/** Calculate all asteroid spawn points of wave on sphere with anchor=Origin, radius=WaveRadius, uses wave own random stream */
+	void CalcWaveSpawnPoints(int32 Seed, int32 Wave, const FVector& Origin, float WaveRadius, int32 WaveAsteroidNum,
+		TFunctionRef<bool(const FVector&)> IsPointAllowed, TArray<FVector>& OutSpawnPoints) const;
 
 	/** Check if next spawn point is farther atleast then SpawnParam.MinSpawnDistanceBetweenAsteroids */
 	FORCEINLINE bool IsAsteroidSpawnPointValid(const FVector& InSpawnPoint);
 
-	// Calculate spawn transform depending on current wave params for single Asteroid instance
-	virtual FTransform CalcAsteroidSpawnTransform();
+	// Calculate spawn transform for single Asteroid instance, steps InOutAsteroidScale
+	virtual FTransform CalcAsteroidSpawnTransform(const FVector& InSpawnPoint, float& InOutAsteroidScale) const;
 
 	/*
 	 * Spawn single Asteroid instance with calculated transform 
 	 */
-	void SpawnAsteroid();
+	void SpawnAsteroid(const FTransform& SpawnTransform);
 
 	/** get location of zero index player controller's pawn of current world */
 	FVector GetNewSpawnOrigin();
 
+	/** Count killed asteroid and start next wave if enough asteroids are killed */
+	void HandleAsteroidKilled();
+
 public:	
 	UPROPERTY(BlueprintAssignable)
 	FOnAsteroidSpawned NotifyAsteroidSpawned;
 
-	/** Check if killed actor is asteroid, if so -> handle asteroid killed */
-	UFUNCTION()
-	void OnActorKilled(AActor* Victim, AActor* Killer, AController* KillerController);
+	/** Native notification, wave count, asteroids to kill for next wave or alive spawned asteroids num is changed */
+	FSimpleMulticastDelegate NotifyWaveStateChanged;
+
+	/** Swap remove asteroid from spawned asteroids by its stored index and free its spawn point, returns false if asteroid is not spawned by spawner */
+	bool RemoveSpawnedAsteroid(AAFPS_Asteroid* Asteroid);
+
+	/** Asteroid kill event from game mode kill event bus -> handle asteroid killed */
+	void OnAsteroidKilled(const FKillEvent& KillEvent);
+
+	/** Get wave random stream seed, depends only on waves seed and wave number */
+	static int32 GetWaveStreamSeed(int32 Seed, int32 Wave);
+
+	/** 
+	 * Calculate wave spawn transforms without spawning and without simulating earlier waves,
+	 * result is equal to spawned wave if SpawnParam.bReplayableWaves is true
+	 */
+	void CalcReplayWaveSpawnTransforms(int32 Seed, int32 Wave, const FVector& Origin, TArray<FTransform>& OutSpawnTransforms) const;
+
+	/** Get waves random seed */
+	UFUNCTION(BlueprintPure, BlueprintCallable)
+	FORCEINLINE int32 GetWavesSeed() const { return WavesSeed; }
+
+	/** Get spawner params */
+	FORCEINLINE const FAsteroidSpawnerParam& GetSpawnParam() const { return SpawnParam; }
 
 	/** Get Wave Count */
 	UFUNCTION(BlueprintPure, BlueprintCallable)
@@ -170,8 +269,20 @@ public:
 	UFUNCTION(BlueprintPure, BlueprintCallable)
 	FORCEINLINE int32 GetAsteroidToKillForNextWave() const { return AsteroidToKillForNextWave; }
 
+	/** Get queued but not yet spawned asteroids num */
+	UFUNCTION(BlueprintPure, BlueprintCallable)
+	FORCEINLINE int32 GetPendingSpawnAsteroidNum() const { return PendingSpawns.Num() - PendingSpawnIndex; }
+
+	/** Get alive spawned asteroids num, including asteroid field instances */
+	UFUNCTION(BlueprintPure, BlueprintCallable)
+	int32 GetAliveSpawnedAsteroidNum() const;
+
+	/** Get instanced asteroid field, nullptr if asteroids are spawned as actors */
+	UFUNCTION(BlueprintPure, BlueprintCallable)
+	FORCEINLINE AAFPS_AsteroidField* GetAsteroidField() const { return AsteroidField; }
+
 	/** Get alive spawned asteroids */
 	UFUNCTION(BlueprintPure, BlueprintCallable)
-	FORCEINLINE TArray<AAFPS_Asteroid*>& GetAliveSpawnedAsteroids() { return SpawnedAsteroids; }
+	FORCEINLINE const TArray<AAFPS_Asteroid*>& GetAliveSpawnedAsteroids() const { return SpawnedAsteroids; }
 
 };
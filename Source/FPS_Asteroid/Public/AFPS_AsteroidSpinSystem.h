@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Asteroids orientation integrator, has no world dependencies
+ * rotation and world space angular velocity are stored as structure of arrays and integrated 4 asteroids at once
+ */
+struct FPS_ASTEROID_API FAsteroidSpinSystem
+{
+	/** Add asteroid, returns its index */
+	int32 Add(const FQuat& Rotation, const FVector& AngularVelocity = FVector::ZeroVector);
+
+	/** Remove asteroid, last asteroid is moved to removed index */
+	void RemoveAtSwap(int32 Index);
+
+	/** Remove all asteroids */
+	void Reset();
+
+	/** Set asteroid rotation and angular velocity, e.g. on reuse */
+	void Set(int32 Index, const FQuat& Rotation, const FVector& AngularVelocity);
+
+	/** Add world space angular velocity, radians per second */
+	void AddAngularVelocity(int32 Index, const FVector& DeltaAngularVelocity);
+
+	/** Stop asteroid spin */
+	void StopSpin(int32 Index);
+
+	/** Rotate all asteroids by their angular velocity, returns true if any asteroid spins */
+	bool Integrate(float DeltaSeconds);
+
+	FORCEINLINE int32 Num() const { return RotX.Num(); }
+
+	FORCEINLINE FQuat GetRotation(int32 Index) const { return FQuat(RotX[Index], RotY[Index], RotZ[Index], RotW[Index]); }
+
+	FORCEINLINE FVector GetAngularVelocity(int32 Index) const { return FVector(AngVelX[Index], AngVelY[Index], AngVelZ[Index]); }
+
+	FORCEINLINE bool IsSpinning(int32 Index) const { return AngVelX[Index] != 0.f || AngVelY[Index] != 0.f || AngVelZ[Index] != 0.f; }
+
+	/** Get allocated memory, for stats */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	TArray<float> RotX;
+	TArray<float> RotY;
+	TArray<float> RotZ;
+	TArray<float> RotW;
+
+	TArray<float> AngVelX;
+	TArray<float> AngVelY;
+	TArray<float> AngVelZ;
+
+	/** Spinning asteroids num, integration is skipped when nothing spins */
+	int32 SpinningNum = 0;
+};
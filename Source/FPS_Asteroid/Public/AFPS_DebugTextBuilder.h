@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Debug overlay text built from printf formatted lines with inline storage, allocates nothing in steady state
+ * line is reformatted only when its format or any argument is changed, text is rebuilt only when any line is changed
+ * lines should be added in same order every frame, arguments are compared bitwise (strings by pointer, so use literals)
+ */
+struct FPS_ASTEROID_API FDebugTextBuilder
+{
+	static constexpr int32 MaxLines = 32;
+	static constexpr int32 MaxLineLen = 128;
+	static constexpr int32 MaxKeySize = 32;
+
+	/** Start new text */
+	void Begin();
+
+	/** Add printf formatted line, format must be TEXT literal */
+	template <int32 FormatLen, typename... ArgTypes>
+	void AddLine(const TCHAR (&Format)[FormatLen], ArgTypes... Args)
+	{
+		static_assert(TAnd<TOr<TIsArithmetic<ArgTypes>, TIsPointer<ArgTypes>>...>::Value, "Debug text line arguments must be numbers or string literals");
+
+		if (!ensure(LineNum < MaxLines))
+		{
+			return;
+		}
+
+		FLine& Line = Lines[LineNum++];
+
+		uint8 Key[MaxKeySize];
+		int32 KeySize = 0;
+		int32 Unused[] = { 0, (AppendKey(Key, KeySize, Args), 0)... };
+		(void)Unused;
+
+		if (Line.Format != Format || Line.KeySize != KeySize || FMemory::Memcmp(Line.Key, Key, KeySize) != 0)
+		{
+			Line.TextLen = FMath::Clamp(FCString::Snprintf(Line.Text, MaxLineLen, Format, Args...), 0, MaxLineLen - 1);
+			Line.Format = Format;
+			Line.KeySize = KeySize;
+			FMemory::Memcpy(Line.Key, Key, KeySize);
+
+			OnLineFormatted();
+		}
+	}
+
+	/** Finish text, returned string is kept between frames */
+	const FString& End();
+
+	/** Get text of last End for canvas drawing, recreated only when text is rebuilt */
+	FORCEINLINE const FText& GetDisplayText() const { return DisplayText; }
+
+private:
+	template <typename T>
+	static FORCEINLINE void AppendKey(uint8* Key, int32& KeySize, const T& Value)
+	{
+		check(KeySize + static_cast<int32>(sizeof(T)) <= MaxKeySize);
+		FMemory::Memcpy(Key + KeySize, &Value, sizeof(T));
+		KeySize += sizeof(T);
+	}
+
+	/** Line was reformatted, text should be rebuilt */
+	void OnLineFormatted();
+
+	struct FLine
+	{
+		const TCHAR* Format = nullptr;
+		uint8 Key[MaxKeySize];
+		int32 KeySize = 0;
+		TCHAR Text[MaxLineLen];
+		int32 TextLen = 0;
+	};
+
+	FLine Lines[MaxLines];
+	int32 LineNum = 0;
+
+	/** Lines num of built text */
+	int32 BuiltLineNum = 0;
+
+	bool bDirty = true;
+
+	FString Text;
+
+	/** Canvas text items take FText, it is cached so unchanged text is drawn without copies */
+	FText DisplayText;
+};
@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Frame time summary of single wave */
+struct FWaveFrameTimeStats
+{
+	int32 Wave = 0;
+	int32 FrameNum = 0;
+	float P50Ms = 0.f;
+	float P95Ms = 0.f;
+	float P99Ms = 0.f;
+	float MaxMs = 0.f;
+
+	/** Spikes num, spikes within AttributionFrames after wave start or kill are counted by cause too */
+	int32 SpikeNum = 0;
+	int32 WaveStartSpikeNum = 0;
+	int32 KillSpikeNum = 0;
+};
+
+/**
+ * Frame time recorder, has no world dependencies and doesn't allocate per frame
+ * current wave frame times go to fixed histogram for percentiles, recent frames are kept in ring buffer,
+ * wave summaries are stored when next wave begins
+ */
+struct FPS_ASTEROID_API FFrameTimeTracker
+{
+	/** Recent frames ring buffer size */
+	static constexpr int32 RingSize = 256;
+
+	/** Histogram resolution and range, longer frames go to last bin */
+	static constexpr float HistogramBinMs = 0.1f;
+	static constexpr int32 HistogramBinNum = 1000;
+
+	/** Frame is spike if it is SpikeFactor times slower than average and slower than SpikeMinMs */
+	float SpikeFactor = 2.f;
+	float SpikeMinMs = 8.f;
+
+	/** Spike is caused by wave start or kill if event was noted this or AttributionFrames previous frames */
+	int32 AttributionFrames = 2;
+
+	FFrameTimeTracker();
+
+	/** Store current wave summary and start collecting new wave */
+	void BeginWave(int32 Wave, uint64 Frame);
+
+	/** Asteroid was killed on Frame */
+	void NoteKill(uint64 Frame);
+
+	/** Record frame time, Frame is frame number frame time is measured on */
+	void AddFrame(float FrameMs, uint64 Frame);
+
+	/** Get current wave summary, percentiles are calculated from histogram */
+	FWaveFrameTimeStats GetCurrentWaveStats() const;
+
+	/** Get finished waves summaries */
+	FORCEINLINE const TArray<FWaveFrameTimeStats>& GetFinishedWaveStats() const { return FinishedWaveStats; }
+
+	/** Calculate recent frames percentile, Percent in [0, 1] */
+	float CalcRecentPercentileMs(float Percent) const;
+
+	/** Get recent frames num, up to RingSize */
+	FORCEINLINE int32 GetRecentFrameNum() const { return FMath::Min<int32>(RingNum, RingSize); }
+
+	/** Write waves summaries (with current wave) and recent frames to CSV files, returns false on error */
+	bool ExportCsv(const FString& WavesPath, const FString& FramesPath) const;
+
+private:
+	/** Current wave histogram percentile, Percent in [0, 1] */
+	float CalcHistogramPercentileMs(float Percent) const;
+
+	/** Recent frames ring buffer, frame ms and spike cause flags */
+	float RingFrameMs[RingSize];
+	uint8 RingFlags[RingSize];
+	uint64 RingNum;
+
+	/** Sort buffer for recent percentiles */
+	mutable float RingSortBuffer[RingSize];
+
+	/** Current wave */
+	uint32 Histogram[HistogramBinNum];
+	FWaveFrameTimeStats CurrentWave;
+
+	/** Running average frame time, spikes are not averaged */
+	float AverageMs;
+
+	uint64 LastWaveStartFrame;
+	uint64 LastKillFrame;
+
+	TArray<FWaveFrameTimeStats> FinishedWaveStats;
+};
@@ -4,10 +4,20 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/GameMode.h"
+#include "AFPS_KillEventBus.h"
+#include "AFPS_AsteroidRayCaster.h"
+#include "AFPS_FrameTimeTracker.h"
 #include "AFPS_GameMode.generated.h"
 
 class AAFPS_Asteroid;
 class AAFPS_AsteroidSpawner;
+class AAFPS_AsteroidField;
+class UAFPS_AsteroidPoolComponent;
+class UAFPS_DamageQueueComponent;
+class UAFPS_AsteroidPhysicsLODComponent;
+class UAFPS_AsteroidSpinComponent;
+class UAFPS_AsteroidSignificanceComponent;
+class UAFPS_BenchmarkComponent;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnActorKilledSignature, AActor*, Victim, AActor*, Killer, AController*, KillerController);
 
@@ -25,6 +35,14 @@ class FPS_ASTEROID_API AAFPS_GameMode : public AGameMode
 	UPROPERTY()
 	AAFPS_AsteroidSpawner* AsteroidSpawner;
 
+	/** Killed asteroids are returned to this pool and reused by AsteroidSpawner */
+	UPROPERTY(Category = Components, VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+	UAFPS_AsteroidPoolComponent* AsteroidPool;
+
+	/** Enable/disable asteroid pool, without pool killed asteroids are destroyed and every asteroid is spawned */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AFPS_GameMode", meta = (AllowPrivateAccess = "true"))
+	bool bUseAsteroidPool;
+
 	/** Total Destroyed Asteroid Num */
 	UPROPERTY()
 	int32 KilledAsteroidNum;
@@ -33,13 +51,105 @@ class FPS_ASTEROID_API AAFPS_GameMode : public AGameMode
 	UPROPERTY()
 	int32 SpawnedAsteroidNum;
 
+	/** Weapon hits are collected here and resolved once per frame */
+	UPROPERTY(Category = Components, VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+	UAFPS_DamageQueueComponent* DamageQueue;
+
+	/** Enable/disable batched damage, without damage queue weapon hits apply damage immediately */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AFPS_GameMode", meta = (AllowPrivateAccess = "true"))
+	bool bUseDamageQueue;
+
+	/** Puts idle and far asteroid bodies to sleep */
+	UPROPERTY(Category = Components, VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+	UAFPS_AsteroidPhysicsLODComponent* AsteroidPhysicsLOD;
+
+	/** Enable/disable asteroid physics LOD, without it all asteroid bodies are simulated all the time */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AFPS_GameMode", meta = (AllowPrivateAccess = "true"))
+	bool bUseAsteroidPhysicsLOD;
+
+	/** Spins asteroid actors without physics simulation */
+	UPROPERTY(Category = Components, VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+	UAFPS_AsteroidSpinComponent* AsteroidSpin;
+
+	/** Enable/disable analytic asteroid spin, when enabled asteroid bodies are not simulated and physics LOD has nothing to do */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AFPS_GameMode", meta = (AllowPrivateAccess = "true"))
+	bool bUseAnalyticAsteroidSpin;
+
+	/** Buckets asteroids by distance and view, less significant asteroids get less updates */
+	UPROPERTY(Category = Components, VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+	UAFPS_AsteroidSignificanceComponent* AsteroidSignificance;
+
+	/** Enable/disable asteroid significance, without it all asteroids are updated equally */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AFPS_GameMode", meta = (AllowPrivateAccess = "true"))
+	bool bUseAsteroidSignificance;
+
+	/** Headless benchmark, runs only with -AFPSBenchmark command line switch */
+	UPROPERTY(Category = Components, VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+	UAFPS_BenchmarkComponent* Benchmark;
+
+	/** Native kill events, categorized by victim */
+	FKillEventBus KillEventBus;
+
+	/** Live asteroids registry, all active asteroid actors on scene, each asteroid stores own index */
+	UPROPERTY()
+	TArray<AAFPS_Asteroid*> LiveAsteroids;
+
+	/**
+	 * Bounding spheres of live asteroids and asteroid field instances, spheres are added and removed with asteroids
+	 * hierarchy is rebuilt lazily, at most once per frame
+	 */
+	FAsteroidRayCaster AsteroidRayCaster;
+
+	/** Ray caster sphere index -> hit component and instance index (INDEX_NONE for actors), nullptr for removed spheres */
+	TArray<TPair<UPrimitiveComponent*, int32>> AsteroidRayTargets;
+
+	/** Live asteroid index -> ray caster sphere index, INDEX_NONE if asteroid has no collision */
+	TArray<int32> LiveAsteroidRaySpheres;
+
+	/** Asteroid field instance index -> ray caster sphere index, INDEX_NONE for dead instances */
+	TArray<int32> FieldInstanceRaySpheres;
+
+	/** True if ray caster hierarchy should be rebuilt, spheres were added or most of them were removed after build */
+	bool bAsteroidRayCasterDirty;
+
+	/** Frame when ray caster hierarchy was built */
+	uint64 AsteroidRayCasterBuildFrame;
+
+	/** Ray caster hits buffer */
+	TArray<FAsteroidRayHit> AsteroidRayHits;
+
+	/** Session frame times by wave, waves and kills are noted by asteroid spawner */
+	FFrameTimeTracker FrameTimeTracker;
+
+	/** Rebuild AsteroidRayCaster from live asteroids registry and asteroid field */
+	void BuildAsteroidRayCaster();
+
+	/** Add ray caster sphere for asteroid, returns INDEX_NONE if asteroid has no collision */
+	int32 AddAsteroidRaySphere(AAFPS_Asteroid* Asteroid);
+
+	/** Add ray caster sphere for asteroid field instance */
+	int32 AddFieldInstanceRaySphere(AAFPS_AsteroidField* Field, int32 InstanceIndex);
+
+	/** Remove ray caster sphere, INDEX_NONE is ignored */
+	void RemoveAsteroidRaySphere(int32 SphereIndex);
+
 public:
 	AAFPS_GameMode();
 
 	/** Transitions to calls BeginPlay on actors. */
 	virtual void StartPlay() override;
 
-	/** On Asteroid Killed Delegate, usually called from AAFPS_HealthComponent */
+	virtual void Tick(float DeltaSeconds) override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Native notification, KilledAsteroidNum is changed */
+	FSimpleMulticastDelegate NotifyKilledAsteroidNumChanged;
+
+	/** Native notification, AsteroidSpawner is created in StartPlay, after actors begin play */
+	FSimpleMulticastDelegate NotifyAsteroidSpawnerCreated;
+
+	/** On Actor Killed blueprint Delegate, usually called from AAFPS_HealthComponent, native code should use GetKillEventBus() */
 	UPROPERTY(BlueprintAssignable)
 	FOnActorKilledSignature NotifyActorKilled;
 
@@ -51,9 +161,61 @@ public:
 	UFUNCTION(BlueprintPure, BlueprintCallable)
 	FORCEINLINE AAFPS_AsteroidSpawner* GetAsteroidSpawner() const { return AsteroidSpawner; }
 
+	/** Add asteroid to live asteroids registry, called when asteroid begins play or is taken from pool */
+	void RegisterLiveAsteroid(AAFPS_Asteroid* Asteroid);
+
+	/** Swap remove asteroid from live asteroids registry by its stored index */
+	void UnregisterLiveAsteroid(AAFPS_Asteroid* Asteroid);
+
+	/** Get all live asteroid actors (any order) */
+	FORCEINLINE const TArray<AAFPS_Asteroid*>& GetLiveAsteroids() const { return LiveAsteroids; }
+
+	/** Get live asteroid actors num */
+	UFUNCTION(BlueprintPure, BlueprintCallable)
+	FORCEINLINE int32 GetLiveAsteroidNum() const { return LiveAsteroids.Num(); }
+
+	/** Add asteroid spawner field instance to ray caster, called when instance is added or reused */
+	void RegisterAsteroidFieldInstance(AAFPS_AsteroidField* Field, int32 InstanceIndex);
+
+	/** Remove asteroid spawner field instance from ray caster, called when instance is killed */
+	void UnregisterAsteroidFieldInstance(AAFPS_AsteroidField* Field, int32 InstanceIndex);
+
+	/**
+	 * Trace ray against asteroids only, bounding spheres are tested first, physics trace refines candidates
+	 * in sphere entry order while they can be closer than nearest refined hit
+	 * @return true if asteroid is hit in Range
+	 */
+	bool RaycastAsteroids(const FVector& Start, const FVector& Direction, float Range, FHitResult& OutHit);
+
+	/** Get asteroid pool, nullptr if pool is disabled */
+	FORCEINLINE UAFPS_AsteroidPoolComponent* GetAsteroidPool() const { return bUseAsteroidPool ? AsteroidPool : nullptr; }
+
+	/** Get damage queue, nullptr if batched damage is disabled */
+	FORCEINLINE UAFPS_DamageQueueComponent* GetDamageQueue() const { return bUseDamageQueue ? DamageQueue : nullptr; }
+
+	/** Get asteroid physics LOD, nullptr if physics LOD is disabled */
+	FORCEINLINE UAFPS_AsteroidPhysicsLODComponent* GetAsteroidPhysicsLOD() const { return bUseAsteroidPhysicsLOD ? AsteroidPhysicsLOD : nullptr; }
+
+	/** Get asteroid spin, nullptr if asteroids are spun by physics simulation */
+	FORCEINLINE UAFPS_AsteroidSpinComponent* GetAsteroidSpin() const { return bUseAnalyticAsteroidSpin ? AsteroidSpin : nullptr; }
+
+	/** Get asteroid significance, nullptr if significance is disabled */
+	FORCEINLINE UAFPS_AsteroidSignificanceComponent* GetAsteroidSignificance() const { return bUseAsteroidSignificance ? AsteroidSignificance : nullptr; }
+
+	/** Get session frame time tracker */
+	FORCEINLINE FFrameTimeTracker& GetFrameTimeTracker() { return FrameTimeTracker; }
+
+	/** Write frame time tracker CSV files to Saved/Profiling, returns false on error */
+	bool ExportFrameTimes() const;
+
+	/** Get benchmark */
+	FORCEINLINE UAFPS_BenchmarkComponent* GetBenchmark() const { return Benchmark; }
+
+	/** Get native kill events bus */
+	FORCEINLINE FKillEventBus& GetKillEventBus() { return KillEventBus; }
+
 	/** On Asteroid Destroy -> incr KilledAsteroidNum */
-	UFUNCTION()
-	void OnActorKilled(AActor* Victim, AActor* Killer, AController* KillerController);
+	void OnAsteroidKilled(const FKillEvent& KillEvent);
 
 	/** On Asteroid Spawned -> Incr SpawnedAsteroidNum */
 	UFUNCTION()
@@ -5,10 +5,41 @@
 #include "CoreMinimal.h"
 #include "GameFramework/HUD.h"
 #include "Engine/Canvas.h"
+#include "AFPS_HUDDrawBatch.h"
+#include "AFPS_ThreatIndicators.h"
+#include "AFPS_DebugTextBuilder.h"
 #include "AFPS_HUD.generated.h"
 
 class AAFPS_Character;
 class AAFPS_GameMode;
+class AAFPS_AsteroidSpawner;
+class AAFPS_Weapon;
+
+/**
+ * HUD values cache, pushed by spawner, game mode and weapon change notifications
+ */
+USTRUCT(BlueprintType)
+struct FHUDViewModel
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "HUD")
+	int32 WaveCount = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "HUD")
+	int32 AsteroidToKillForNextWave = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "HUD")
+	int32 AliveSpawnedAsteroidNum = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "HUD")
+	int32 KilledAsteroidNum = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "HUD")
+	float WeaponEnergyLevelAlpha = 0.f;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnHUDViewModelChanged, const FHUDViewModel&, ViewModel);
 
 /**
  * 
@@ -25,6 +56,31 @@ class FPS_ASTEROID_API AAFPS_HUD : public AHUD
 	UPROPERTY()
 	FCanvasIcon CrosshairIcon;
 
+	/** Off-screen asteroid indicator texture, arrow should point right, white quad if not set */
+	UPROPERTY(EditDefaultsOnly, Category = "ThreatIndicators")
+	UTexture2D* ThreatIndicatorTexture;
+
+	/** Nearest off-screen asteroids num to show indicators for, 0 disables indicators */
+	UPROPERTY(EditDefaultsOnly, Category = "ThreatIndicators")
+	int32 MaxThreatIndicators;
+
+	/** Indicator size and distance from screen edge, pixels */
+	UPROPERTY(EditDefaultsOnly, Category = "ThreatIndicators")
+	float ThreatIndicatorSize;
+
+	UPROPERTY(EditDefaultsOnly, Category = "ThreatIndicators")
+	float ThreatIndicatorEdgeMargin;
+
+	/** Indicator color is NearColor at zero distance and FarColor at FarDistance and farther */
+	UPROPERTY(EditDefaultsOnly, Category = "ThreatIndicators")
+	FLinearColor ThreatIndicatorNearColor;
+
+	UPROPERTY(EditDefaultsOnly, Category = "ThreatIndicators")
+	FLinearColor ThreatIndicatorFarColor;
+
+	UPROPERTY(EditDefaultsOnly, Category = "ThreatIndicators")
+	float ThreatIndicatorFarDistance;
+
 	/** Player Character HUD Owner */
 	UPROPERTY()
 	AAFPS_Character* Character;
@@ -33,12 +89,62 @@ class FPS_ASTEROID_API AAFPS_HUD : public AHUD
 	UPROPERTY()
 	AAFPS_GameMode* GM;
 
+	/** Screen space elements of frame, drawn at once at the end of DrawHUD */
+	FHUDDrawBatch DrawBatch;
+
+	/** Nearest off-screen asteroids of frame */
+	FAsteroidThreatIndicators ThreatIndicators;
+
+	/** Alive asteroids positions buffer for threat indicators pass */
+	TArray<FVector> ThreatPositions;
+
+	/** Cached HUD values, getters read it without walking game objects */
+	FHUDViewModel ViewModel;
+
+	/** ViewModel was changed after last NotifyViewModelChanged */
+	bool bViewModelDirty;
+
+	/** View model sources bound to, spawner and weapon can appear after HUD begins play, tick polls them only until both are bound */
+	TWeakObjectPtr<AAFPS_AsteroidSpawner> BoundSpawner;
+	TWeakObjectPtr<AAFPS_Weapon> BoundWeapon;
+
+	#if WITH_EDITOR
+	/** Debug overlay text of frame, builder is owned by Owner actor and is not copied */
+	struct FDebugTextOverlay
+	{
+		TWeakObjectPtr<const AActor> Owner;
+		const FDebugTextBuilder* Text;
+		FVector Location;
+		FLinearColor Color;
+	};
+
+	/** Debug overlay texts added during frame, drawn and dropped by DrawHUD, buffer is kept between frames */
+	TArray<FDebugTextOverlay> DebugTexts;
+	#endif  // WITH_EDITOR
+
 public:
 	AAFPS_HUD();
 	
 	/** Main HUD update loop. */
 	virtual void DrawHUD() override;
 
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** View model is changed, called once per frame at most, UI should update on this instead of polling getters */
+	UPROPERTY(BlueprintAssignable)
+	FOnHUDViewModelChanged NotifyViewModelChanged;
+
+	#if WITH_EDITOR
+	/** Draw debug text at world location this frame, replaces DrawDebugString which copies text every frame */
+	void AddDebugText(const AActor* Owner, const FDebugTextBuilder& Text, const FVector& Location, const FLinearColor& Color);
+	#endif  // WITH_EDITOR
+
+	/** Get HUD draw batch, has draw items and quads num of last frame */
+	FORCEINLINE const FHUDDrawBatch& GetDrawBatch() const { return DrawBatch; }
+
+	/** Get cached HUD values */
+	UFUNCTION(BlueprintPure, BlueprintCallable)
+	FORCEINLINE FHUDViewModel GetViewModel() const { return ViewModel; }
 
 	/** Get from GameMode AsteroidSpawner current wave count */
 	UFUNCTION(BlueprintPure, BlueprintCallable)
@@ -64,4 +170,33 @@ public:
 protected:
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	/** Find nearest off-screen asteroids and add their indicators to draw batch */
+	void DrawThreatIndicators();
+
+	#if WITH_EDITOR
+	/** Draw debug overlay texts of frame with their cached display text */
+	void DrawDebugTexts();
+	#endif  // WITH_EDITOR
+
+	/** Subscribe to spawner and weapon once they exist, rebind when weapon is changed, called on spawner and weapon notifications */
+	void BindViewModelSources();
+
+	/** Set view model field, mark view model dirty if value is changed */
+	template <typename T>
+	FORCEINLINE void SetViewModelValue(T& Field, T Value)
+	{
+		if (Field != Value)
+		{
+			Field = Value;
+			bViewModelDirty = true;
+		}
+	}
+
+	/** View model source notifications */
+	void OnWaveStateChanged();
+	void OnKilledAsteroidNumChanged();
+	void OnWeaponEnergyChanged(float EnergyLevelAlpha);
 };
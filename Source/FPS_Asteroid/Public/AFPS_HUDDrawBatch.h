@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CanvasItem.h"
+
+class FCanvas;
+class UTexture;
+struct FCanvasIcon;
+
+/**
+ * Screen space HUD quads collected during DrawHUD and submitted as single canvas triangle item per texture,
+ * so canvas item num doesn't depend on drawn elements num, buffers are kept between frames
+ */
+struct FPS_ASTEROID_API FHUDDrawBatch
+{
+	/** Drop collected quads, keep buffers */
+	void Reset();
+
+	/** Add textured quad centered at Center, rotated clockwise by RotationDeg around its center */
+	void AddQuad(UTexture* Texture, const FVector2D& Center, const FVector2D& Size, const FVector2D& UV0, const FVector2D& UV1,
+		const FLinearColor& Color, float RotationDeg = 0.f);
+
+	/** Add canvas icon centered at Center */
+	void AddIcon(const FCanvasIcon& Icon, const FVector2D& Center, float Scale, const FLinearColor& Color, float RotationDeg = 0.f);
+
+	/** Draw collected quads, one canvas item per texture */
+	void Flush(FCanvas* Canvas);
+
+	/** Get quads num added after Reset */
+	FORCEINLINE int32 GetQuadNum() const { return QuadNum; }
+
+	/** Get canvas items num drawn by last Flush */
+	FORCEINLINE int32 GetDrawItemNum() const { return DrawItemNum; }
+
+private:
+	struct FTextureBatch
+	{
+		UTexture* Texture;
+		FCanvasTriangleItem Item;
+	};
+
+	/** Get batch of texture, HUD uses few textures so it is linear search */
+	FCanvasTriangleItem& GetTextureItem(UTexture* Texture);
+
+	TArray<FTextureBatch> Batches;
+
+	int32 QuadNum = 0;
+	int32 DrawItemNum = 0;
+};
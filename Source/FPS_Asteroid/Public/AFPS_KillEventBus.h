@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AFPS_KillEventBus.generated.h"
+
+class AAFPS_Asteroid;
+class AAFPS_AsteroidField;
+
+/** Killed actor category, kill event subscribers can listen to single category */
+UENUM(BlueprintType)
+enum class EKillVictimCategory : uint8
+{
+	Other,
+	Asteroid,  // AAFPS_Asteroid actor or AAFPS_AsteroidField instance
+	Player,
+	Dummy,
+
+	MAX UMETA(Hidden)
+};
+
+/**
+ * Kill event data, classified once by event source
+ */
+struct FKillEvent
+{
+	/** Killed actor, asteroid field for field instance kills */
+	AActor* Victim = nullptr;
+
+	AActor* Killer = nullptr;
+
+	AController* KillerController = nullptr;
+
+	EKillVictimCategory Category = EKillVictimCategory::Other;
+
+	/** Killed asteroid field instance index, INDEX_NONE for actor kills */
+	int32 InstanceIndex = INDEX_NONE;
+
+	/** Check if killed asteroid is asteroid field instance */
+	FORCEINLINE bool IsFieldInstance() const { return InstanceIndex != INDEX_NONE; }
+
+	/** Get killed asteroid actor, valid only for Asteroid category actor kills */
+	AAFPS_Asteroid* GetAsteroid() const;
+
+	/** Get killed instance asteroid field, valid only for Asteroid category instance kills */
+	AAFPS_AsteroidField* GetAsteroidField() const;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnKillEvent, const FKillEvent&);
+
+/**
+ * Native kill events channel, owned by game mode
+ * kill is broadcasted to its victim category subscribers and to any kill subscribers, without reflection calls
+ */
+struct FPS_ASTEROID_API FKillEventBus
+{
+	/** Kill events of single victim category */
+	FORCEINLINE FOnKillEvent& OnKill(EKillVictimCategory Category) { return CategoryKillDelegates[static_cast<uint8>(Category)]; }
+
+	/** All kill events */
+	FORCEINLINE FOnKillEvent& OnAnyKill() { return AnyKillDelegate; }
+
+	/** Notify category and any kill subscribers */
+	void Broadcast(const FKillEvent& KillEvent);
+
+	/** Remove all subscriptions of object */
+	void RemoveAll(const void* InUserObject);
+
+private:
+	FOnKillEvent CategoryKillDelegates[static_cast<uint8>(EKillVictimCategory::MAX)];
+
+	FOnKillEvent AnyKillDelegate;
+};
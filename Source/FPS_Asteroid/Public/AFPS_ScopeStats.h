@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+#include <FPS_Asteroid/FPS_Asteroid.h>
+
+/**
+ * Game thread scope timing, collected since last AFPS.Stats.Reset and printed as table by AFPS.Stats.Dump
+ * each declared scope stat is also "stat FPSAsteroid" cycle counter with per frame calls counter and Unreal Insights cpu event
+ */
+struct FPS_ASTEROID_API FAFPS_ScopeStat
+{
+	explicit FAFPS_ScopeStat(const TCHAR* InName);
+
+	/** Add finished scope time */
+	FORCEINLINE void AddCall(uint32 ScopeCycles)
+	{
+		++Calls;
+		Cycles += ScopeCycles;
+		MaxCycles = FMath::Max(MaxCycles, ScopeCycles);
+	}
+
+	const TCHAR* Name;
+	uint64 Calls = 0;
+	uint64 Cycles = 0;
+	uint32 MaxCycles = 0;
+
+	/** Next declared scope stat */
+	FAFPS_ScopeStat* Next;
+
+	/** Get first declared scope stat, stats are linked by Next */
+	static FAFPS_ScopeStat*& GetFirst();
+};
+
+/** Measures scope time to FAFPS_ScopeStat */
+struct FAFPS_ScopeStatCounter
+{
+	FORCEINLINE explicit FAFPS_ScopeStatCounter(FAFPS_ScopeStat& InStat)
+		: Stat(InStat)
+		, StartCycles(FPlatformTime::Cycles())
+	{
+	}
+
+	FORCEINLINE ~FAFPS_ScopeStatCounter()
+	{
+		Stat.AddCall(FPlatformTime::Cycles() - StartCycles);
+	}
+
+private:
+	FAFPS_ScopeStat& Stat;
+	uint32 StartCycles;
+};
+
+#if !UE_BUILD_SHIPPING
+
+/** Declare scope stat in cpp file, Description is shown in stat and dump output */
+#define AFPS_DECLARE_SCOPE_STAT(Description, StatName) \
+	DECLARE_CYCLE_STAT(TEXT(Description), STAT_##StatName, STATGROUP_FPSAsteroid); \
+	DECLARE_DWORD_COUNTER_STAT(TEXT(Description " Calls"), STAT_##StatName##Calls, STATGROUP_FPSAsteroid); \
+	static FAFPS_ScopeStat AFPSScopeStat_##StatName(TEXT(Description))
+
+/** Measure current scope by declared scope stat, game thread only */
+#define AFPS_SCOPE_STAT(StatName) \
+	SCOPE_CYCLE_COUNTER(STAT_##StatName); \
+	INC_DWORD_STAT(STAT_##StatName##Calls); \
+	TRACE_CPUPROFILER_EVENT_SCOPE(StatName); \
+	FAFPS_ScopeStatCounter AFPSScopeStatCounter_##StatName(AFPSScopeStat_##StatName)
+
+#else
+
+#define AFPS_DECLARE_SCOPE_STAT(Description, StatName)
+#define AFPS_SCOPE_STAT(StatName)
+
+#endif // !UE_BUILD_SHIPPING
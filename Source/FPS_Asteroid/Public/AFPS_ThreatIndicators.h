@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Off-screen asteroid indicator */
+struct FThreatIndicator
+{
+	/** Normalized screen space direction from screen center, Y is down */
+	FVector2D Direction;
+
+	/** Distance from view location */
+	float Distance;
+
+	/** Index in positions passed to Update */
+	int32 SourceIndex;
+};
+
+/**
+ * Nearest off-screen asteroids, has no world dependencies
+ * positions are projected in parallel chunks, every chunk keeps its own nearest candidates, so only
+ * chunks num * max indicators candidates are sorted on calling thread
+ */
+struct FPS_ASTEROID_API FAsteroidThreatIndicators
+{
+	/** Positions num projected by single parallel task */
+	static constexpr int32 ChunkSize = 512;
+
+	/** Find up to MaxIndicators off-screen positions nearest to ViewLocation, indicators are sorted nearest first */
+	void Update(const FVector& ViewLocation, const FMatrix& ViewProjectionMatrix, TArrayView<const FVector> Positions, int32 MaxIndicators);
+
+	/** Get indicators of last Update */
+	FORCEINLINE const TArray<FThreatIndicator>& GetIndicators() const { return Indicators; }
+
+private:
+	/** Per chunk nearest candidates, MaxIndicators slots per chunk, sorted nearest first */
+	TArray<FThreatIndicator> ChunkCandidates;
+	TArray<int32> ChunkCandidateNum;
+
+	TArray<FThreatIndicator> Indicators;
+};
@@ -5,9 +5,11 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
 #include <FPS_Asteroid/FPS_Asteroid.h>
+#include "Character/AFPS_ViewQueryCache.h"
 #include "AFPS_Character.generated.h"
 
 extern TAutoConsoleVariable<bool> CVarDrawDebugCharacter;
+extern TAutoConsoleVariable<bool> CVarAsyncLookTrace;
 
 class UCameraComponent;
 class UAnimMontage;
@@ -99,6 +101,24 @@ class FPS_ASTEROID_API AAFPS_Character : public ACharacter
 	UPROPERTY(BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 	mutable FHitResult LookTrace;
 
+	// async look trace result back buffer, swapped with LookTrace on next tick
+	FHitResult PendingLookTrace;
+
+	// frame number when LookTrace was requested
+	uint64 LookTraceFrame;
+
+	// frame number when PendingLookTrace was requested
+	uint64 PendingLookTraceFrame;
+
+	// true if PendingLookTrace has new result
+	bool bPendingLookTraceReady;
+
+	// async look trace completion callback
+	FTraceDelegate LookTraceDelegate;
+
+	// eye ray hit traced once per frame, shared with weapon shot
+	FViewQueryCache ViewQueryCache;
+
 	/** character current weapon */
 	UPROPERTY()
 	AAFPS_Weapon* WeaponInHands;
@@ -121,6 +141,9 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "FPSCharacter")
 	void SpawnWeaponAttached(bool bDestroyOldWeapon = false);
 
+	/** Native notification, weapon in hands is spawned or character is unpossessed, so player weapon is changed */
+	FSimpleMulticastDelegate NotifyWeaponChanged;
+
 	/** Play Weapon shooting anim monatge */
 	UFUNCTION(BlueprintCallable, Category = "FPSCharacter")
 	void PlayFireAnimMontage();
@@ -136,6 +159,8 @@ public:
 	// Called to bind functionality to input
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
+	virtual void UnPossessed() override;
+
 	/**
 	* fly forward/back
 	*
@@ -202,6 +227,16 @@ public:
 	UFUNCTION(BlueprintPure, BlueprintCallable, Category = "Weapon")
 	FORCEINLINE FHitResult& GetLookTraceResult() const { return LookTrace; }
 
+	/** Get how many frames old is look trace result, 0 for sync trace, >= 1 for async trace */
+	UFUNCTION(BlueprintPure, BlueprintCallable, Category = Character)
+	FORCEINLINE int32 GetLookTraceAgeFrames() const { return static_cast<int32>(GFrameCounter - LookTraceFrame); }
+
+	/** 
+	 * Get eye ray hit, eye ray is traced once per frame and shared between look point trace and weapon shot
+	 * @return true if blocking hit found in Range
+	 */
+	bool QueryViewHit(const FVector& Start, const FVector& Direction, float Range, ECollisionChannel Channel, FHitResult& OutHit);
+
 	/** Get character veiw point, if trace fail -> get far max view point */
 	UFUNCTION(BlueprintPure, BlueprintCallable, Category = Character)
 	FORCEINLINE FVector GetCharacterViewPoint() const
@@ -225,22 +260,10 @@ private:
 		return LookPointMax;
 	}
 
-	/** Get max allowed character look focus line
-	*/
-	FORCEINLINE void GetLookTraceLine(FVector& OutLookPointStart, FVector& OutLookPointEnd) const
-	{
-		FRotator EyeRot;
-		GetActorEyesViewPoint(OutLookPointStart, EyeRot);
-		OutLookPointEnd = OutLookPointStart + EyeRot.Vector() * TRACE_DIST_MAX;
-	}
+	/** OnTick look point trace, blocking or async depending on AFPS.Character.AsyncLookTrace */
+	void LookPointTrace();
 
-	/** OnTick look point trace */
-	FORCEINLINE void LookPointTrace()
-	{
-		FVector TraceStart;
-		FVector TraceEnd;
-		GetLookTraceLine(TraceStart, TraceEnd);
-		GetWorld()->LineTraceSingleByChannel(LookTrace, TraceStart, TraceEnd, LookLineTraceChannel, LookTraceQueryParams);
-	}
+	/** Async look trace is done, store result to back buffer */
+	void OnLookTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
 
 };
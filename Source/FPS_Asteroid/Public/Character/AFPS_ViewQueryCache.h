@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Per frame eye ray query result, shared by character look point and weapon shot
+ * ray is traced against simple collision once per frame, per poly trace is done only for near hits and only against hit component
+ * with async look trace the look point reuses ray of last weapon shot of previous frame instead of tracing its own
+ */
+struct FPS_ASTEROID_API FViewQueryCache
+{
+	/** Simple collision hits closer than this are refined with complex (per poly) collision */
+	float ComplexRefineDistance = 5000.f;  // 50 m
+
+	/** Max traced distance, queries with bigger range are not cached */
+	float MaxDistance = 0.f;
+
+	/**
+	 * Get eye ray hit, reuse trace done this frame for same ray and channel
+	 * @param Range hits farther than range are ignored
+	 * @return true if blocking hit found in range
+	 */
+	bool Query(const UWorld* World, const FVector& Start, const FVector& Direction, float Range, ECollisionChannel Channel,
+		const FCollisionQueryParams& Params, FHitResult& OutHit);
+
+	/** Drop cached result, next query will trace again */
+	FORCEINLINE void Invalidate() { Frame = MAX_uint64; }
+
+	/** Check if cached result was traced this frame for same ray and channel */
+	bool IsValidFor(const FVector& InStart, const FVector& InDirection, ECollisionChannel InChannel) const;
+
+	/** Get cached hit, traced to MaxDistance */
+	FORCEINLINE const FHitResult& GetHit() const { return Hit; }
+
+	/**
+	 * Get hit traced on previous frame for channel (e.g. by last weapon shot), it's as old as async trace result requested last frame
+	 * @param OutFrame frame when hit was traced
+	 * @return false if nothing was traced for channel on previous frame
+	 */
+	bool GetPreviousFrameHit(ECollisionChannel InChannel, FHitResult& OutHit, uint64& OutFrame) const;
+
+private:
+	/** Trace ray with simple collision and refine near hit with complex collision */
+	void Trace(const UWorld* World, const FCollisionQueryParams& Params);
+
+	uint64 Frame = MAX_uint64;
+	FVector Start = FVector::ZeroVector;
+	FVector Direction = FVector::ZeroVector;
+	ECollisionChannel Channel = ECC_MAX;
+	FHitResult Hit;
+};
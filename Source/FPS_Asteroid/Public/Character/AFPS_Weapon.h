@@ -4,13 +4,27 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "AFPS_DebugTextBuilder.h"
 #include "AFPS_Weapon.generated.h"
 
 extern TAutoConsoleVariable<bool> CVarDrawDebugWeapon;
+extern TAutoConsoleVariable<bool> CVarFastShotTrace;
 
 class USkeletalMeshComponent;
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnWeaponEnergyChanged, float /* EnergyLevelAlpha */);
 class AAFPSCharacter;
 
+/**
+ * Single shot owed by fire scheduler, eye view is interpolated to shot time
+ */
+struct FWeaponShot
+{
+	float Time;
+	FVector EyeLocation;
+	FRotator EyeRotation;
+};
+
 //=============================================================================
 /**
  * This is not exactly base class for weapons
@@ -27,11 +41,13 @@ class FPS_ASTEROID_API AAFPS_Weapon : public AActor
 	UPROPERTY(Category = "Weapon", VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 	USkeletalMeshComponent* MeshComp;
 
+	#if WITH_EDITOR
 	// place where we can visualise some debug info
 	FORCEINLINE void DrawDebug(float DeltaSeconds);
 
-	// default weapon hit line trace params
-	FCollisionQueryParams HitTraceQueryParams;
+	/** Draw debug text, kept between frames */
+	FDebugTextBuilder DebugText;
+	#endif  // WITH_EDITOR
 
 	/** AFPSChracter who has this weapon attached to itself */
 	UPROPERTY()
@@ -56,6 +72,9 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Weapon")
 	void StopFire();
 
+	/** Native notification, current energy level is changed */
+	FOnWeaponEnergyChanged NotifyEnergyChanged;
+
 	/** should be called when attached to character */
 	UFUNCTION(BlueprintCallable, Category = "Weapon")
 	void OnAttach(AAFPS_Character* InCharacterOwner);
@@ -95,6 +114,10 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Weapon")
 	float EnergyLevel;
 
+	/** Max shots fired in single frame, owed shots above it are fired next frames */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Weapon", meta = (ClampMin = "1"))
+	int32 MaxShotsPerFrame;
+
 	/** Weapon Energy points recovery per second when not shooting */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Weapon")
 	float EnergyRecoveryRate;
@@ -108,9 +131,6 @@ protected:
 	TSubclassOf<UDamageType>  DamageType;
 
 private:
-	// timer to handle fire logic
-	FTimerHandle TimerHandle_FireLoop;
-
 	/** True if fire key pressed */
 	bool bWantsToFire;
 
@@ -120,15 +140,43 @@ private:
 	/** True if actual fire loop is running */
 	bool bIsFiring;
 
-	/** Energy level next target, used to smooth weapon energy level changing */
-	float EnergyLevelTarget;
+	/** Energy segment started by last state change, energy at any time is evaluated from it */
+	float EnergyAnchorTime;
+	float EnergyAnchorLevel;
+
+	/** Energy points change per second in segment, negative while firing, zero when idle */
+	float EnergyRate;
+
+	/** Level where segment ends, drained level while firing, full level while recovering */
+	float EnergyLimitLevel;
 
-	/** Actual energy level of weapon, calculated each frame*/
-	float CurrentEnergyLevel;
+	/** World time when segment reaches its limit, drained or restored event is executed then */
+	float EnergyEventTime;
+
+	/** Shots paid by running fire segment and not fired yet */
+	int32 ShotsLeft;
+
+	/** Energy alpha of last NotifyEnergyChanged broadcast */
+	float LastNotifiedEnergyAlpha;
 
 	/** Last time when firing was instigated, used to disallow fire button spamming */
 	float LastTimeWhenFiringStarts;
 
+	/** World time of next shot owed by fire scheduler, advanced by FireRate per shot */
+	float NextShotTime;
+
+	/** World time of last fired shot */
+	float LastShotTime;
+
+	/** Eye view point at previous tick, shots between ticks interpolate from it */
+	FVector PrevEyeLocation;
+	FRotator PrevEyeRotation;
+	float PrevEyeTime;
+	bool bHasPrevEye;
+
+	/** Shots fired this frame, kept between frames to avoid allocations */
+	TArray<FWeaponShot> FrameShots;
+
 	/** check if time between last shoot try is > StartFireDelay */
 	bool CanStartShooting();
 
@@ -139,20 +187,21 @@ private:
 	/** Start Fire logic */
 	void StartFire_Internal();
 
-	/** Function to execute delayed single fire shot logic or to stop it 
-	 * @param bShouldReset if true - reset timer, false - cancel timer
-	 */
-	void ResetShotTimer(bool bShouldReset);
-	/** Single Shot linetrace handling */
-	void ShotLineTrace();
-	/** Fire loop logic */
-	void FireLoop();
+	/** Single Shot linetrace handling from given eye view point */
+	void ShotLineTrace(const FVector& EyeLocation, const FRotator& EyeRotation);
+	/** Fire loop logic, fires all shots owed up to current world time as one batch */
+	void FireScheduledShots();
+	/** Remember eye view point of this tick for next frame shots interpolation */
+	void CachePrevEyeViewPoint();
 
 	/** Stop fire logic. Executed when bWantsToFire is become false again */
 	void StopFire_Internal();
 
-	/** Frame-per-frame Tick energy calculation, decreased when firing, increased when not firining */
-	FORCEINLINE void OnTickCalculateEnergyLevel(float DeltaSeconds);
+	/** Start new energy segment, segment ends at LimitLevel reached with Rate */
+	void SetEnergySegment(float Time, float Level, float Rate, float LimitLevel);
+
+	/** Execute drained/restored event when its time has come and notify energy change */
+	void ProcessEnergyEvents();
 
 protected:
 	//=============================================================================
@@ -218,15 +267,22 @@ public:
 	UFUNCTION(BlueprintPure, BlueprintCallable, Category = "Weapon")
 	FORCEINLINE FName GetMuzzleSocketName() const { return MuzzleSocketName; }
 
+	/** get weapon energy level at world time, valid for times after last state change */
+	float CalcEnergyLevelAt(float Time) const;
+
 	/** get weapon current energy level */
 	UFUNCTION(BlueprintPure, BlueprintCallable, Category = "Weapon")
-	FORCEINLINE float GetCurrentEnergyLevel() const { return CurrentEnergyLevel; }
+	float GetCurrentEnergyLevel() const;
 
 	/** get normalized current energy level from 0.0 to 1.0 where 1.0 when its equal to default EnergyLevel */
 	UFUNCTION(BlueprintPure, BlueprintCallable, Category = "Weapon")
-	FORCEINLINE float GetEnergyLevelAlpha() const { return FMath::Clamp(CurrentEnergyLevel / EnergyLevel, 0.f, 1.f); }
+	FORCEINLINE float GetEnergyLevelAlpha() const { return FMath::Clamp(GetCurrentEnergyLevel() / EnergyLevel, 0.f, 1.f); }
 
 	/** get weapon last hit trace result */
 	UFUNCTION(BlueprintPure, BlueprintCallable, Category = "Weapon")
 	FORCEINLINE FHitResult& GetLastShotHitTraceResult() const { return LastHit; }
+
+	/** get world time of last fired shot */
+	UFUNCTION(BlueprintPure, BlueprintCallable, Category = "Weapon")
+	FORCEINLINE float GetLastShotTime() const { return LastShotTime; }
 };
@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "PhysicsPublic.h"
+#include "AFPS_AsteroidPhysicsLODComponent.generated.h"
+
+/**
+ * Puts live asteroid rigid bodies to sleep when they were not hit for a while, far asteroids fall asleep sooner
+ * asteroids only spin, so sleeping body is just not spinning, any hit impulse wakes it back
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class FPS_ASTEROID_API UAFPS_AsteroidPhysicsLODComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+	/** Asteroids farther from player view point use FarSleepDelay, low significance is used instead if significance is enabled */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AsteroidPhysicsLOD", meta = (AllowPrivateAccess = "true"))
+	float SleepDistance;
+
+	/** Seconds without hit before near asteroid body is put to sleep */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AsteroidPhysicsLOD", meta = (AllowPrivateAccess = "true"))
+	float NearSleepDelay;
+
+	/** Seconds without hit before far asteroid body is put to sleep */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AsteroidPhysicsLOD", meta = (AllowPrivateAccess = "true"))
+	float FarSleepDelay;
+
+	/** Awake asteroid bodies on last update */
+	int32 ActiveBodyNum;
+
+	/** Sleeping asteroid bodies on last update */
+	int32 SleepingBodyNum;
+
+	/** Physics scene step start time of current frame, 0 if step is not running */
+	double StepStartSeconds;
+
+	/** Last measured physics step time per awake asteroid body */
+	double AwakeBodySeconds;
+
+	FDelegateHandle PhysScenePreTickHandle;
+	FDelegateHandle PhysScenePostTickHandle;
+
+	/** Physics scene step notifications, sleeping bodies saved time is reported to significance after step */
+	void OnPhysScenePreTick(FPhysScene* PhysScene, float DeltaSeconds);
+	void OnPhysScenePostTick(FPhysScene* PhysScene);
+
+protected:
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+	// Sets default values for this component's properties
+	UAFPS_AsteroidPhysicsLODComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Get awake asteroid bodies num */
+	UFUNCTION(BlueprintPure, BlueprintCallable, Category = "AsteroidPhysicsLOD")
+	FORCEINLINE int32 GetActiveBodyNum() const { return ActiveBodyNum; }
+
+	/** Get sleeping asteroid bodies num */
+	UFUNCTION(BlueprintPure, BlueprintCallable, Category = "AsteroidPhysicsLOD")
+	FORCEINLINE int32 GetSleepingBodyNum() const { return SleepingBodyNum; }
+};
@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "AFPS_AsteroidPoolComponent.generated.h"
+
+class AAFPS_Asteroid;
+
+/**
+ * Asteroid actors pool, killed asteroids are deactivated and reused on next spawn instead of Destroy()/SpawnActor()
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class FPS_ASTEROID_API UAFPS_AsteroidPoolComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+	/** Deactivated asteroids ready to reuse */
+	UPROPERTY()
+	TArray<AAFPS_Asteroid*> FreeAsteroids;
+
+	/** Acquire calls served by pooled asteroid */
+	UPROPERTY(BlueprintReadOnly, Category = "AsteroidPool", meta = (AllowPrivateAccess = "true"))
+	int32 PoolHits;
+
+	/** Acquire calls which have to spawn new asteroid */
+	UPROPERTY(BlueprintReadOnly, Category = "AsteroidPool", meta = (AllowPrivateAccess = "true"))
+	int32 PoolMisses;
+
+public:
+	// Sets default values for this component's properties
+	UAFPS_AsteroidPoolComponent();
+
+	/** Spawn deactivated asteroids to pool, so they can be acquired later without spawning */
+	void Prewarm(TSubclassOf<AAFPS_Asteroid> AsteroidClass, int32 Num);
+
+	/** Get activated asteroid from pool, spawn new one if there is no free asteroid of AsteroidClass */
+	AAFPS_Asteroid* Acquire(TSubclassOf<AAFPS_Asteroid> AsteroidClass, const FTransform& SpawnTransform);
+
+	/** Deactivate asteroid and return it to pool */
+	void Release(AAFPS_Asteroid* Asteroid);
+
+	/** Destroy all deactivated asteroids */
+	void DestroyFreeAsteroids();
+
+	/** Get deactivated asteroids num */
+	UFUNCTION(BlueprintPure, BlueprintCallable, Category = "AsteroidPool")
+	FORCEINLINE int32 GetFreeNum() const { return FreeAsteroids.Num(); }
+
+	/** Get acquire calls num served from pool */
+	FORCEINLINE int32 GetPoolHits() const { return PoolHits; }
+
+	/** Get acquire calls num which spawned new asteroid */
+	FORCEINLINE int32 GetPoolMisses() const { return PoolMisses; }
+
+private:
+	AAFPS_Asteroid* SpawnAsteroid(TSubclassOf<AAFPS_Asteroid> AsteroidClass, const FTransform& SpawnTransform);
+};
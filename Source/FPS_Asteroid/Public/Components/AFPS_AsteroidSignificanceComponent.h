@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "AFPS_AsteroidSignificanceComponent.generated.h"
+
+/** Asteroid relevance for player, less significant asteroids get less updates */
+UENUM(BlueprintType)
+enum class EAsteroidSignificance : uint8
+{
+	High,    // near player
+	Medium,  // in view
+	Low,     // far or out of view
+	Culled,  // beyond weapon reach, rarely updated, hidden unless spawned by wave
+
+	MAX UMETA(Hidden)
+};
+
+/**
+ * Buckets live asteroids by distance from player and view frustum, few asteroids are updated each frame
+ * significance drives physics sleep, analytic spin update rate, render visibility and death fx budget
+ * wave asteroids are never hidden, player has to see every asteroid left in wave
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class FPS_ASTEROID_API UAFPS_AsteroidSignificanceComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+	/** Asteroids closer than this are High significance, even out of view */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AsteroidSignificance", meta = (AllowPrivateAccess = "true"))
+	float HighDistance;
+
+	/** Asteroids in view closer than this are Medium significance, others are Low */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AsteroidSignificance", meta = (AllowPrivateAccess = "true"))
+	float MediumDistance;
+
+	/** Asteroids farther than this are Culled, default is trace distance limit, so weapon can't hit culled asteroid */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AsteroidSignificance", meta = (AllowPrivateAccess = "true"))
+	float CullDistance;
+
+	/** Frames to update significance of all live asteroids */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AsteroidSignificance", meta = (AllowPrivateAccess = "true", ClampMin = "1"))
+	int32 UpdateFrames;
+
+	/** Low significance asteroids are updated once per this frames num */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AsteroidSignificance", meta = (AllowPrivateAccess = "true", ClampMin = "1"))
+	int32 LowUpdateFrameInterval;
+
+	/** Culled significance asteroids are updated once per this frames num */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AsteroidSignificance", meta = (AllowPrivateAccess = "true", ClampMin = "1"))
+	int32 CulledUpdateFrameInterval;
+
+	/** Death fx played per frame by asteroids of each significance, fx over budget is skipped, negative is unlimited */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AsteroidSignificance", meta = (AllowPrivateAccess = "true"))
+	int32 HighDeathFXBudget;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AsteroidSignificance", meta = (AllowPrivateAccess = "true"))
+	int32 MediumDeathFXBudget;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AsteroidSignificance", meta = (AllowPrivateAccess = "true"))
+	int32 LowDeathFXBudget;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AsteroidSignificance", meta = (AllowPrivateAccess = "true"))
+	int32 CulledDeathFXBudget;
+
+	/** Death fx played this frame per significance */
+	int32 DeathFXNum[static_cast<uint8>(EAsteroidSignificance::MAX)];
+
+	/** Next live asteroid index to update */
+	int32 UpdateCursor;
+
+	/** Bucket counts of running and of last complete update pass */
+	int32 PendingBucketNum[static_cast<uint8>(EAsteroidSignificance::MAX)];
+	int32 BucketNum[static_cast<uint8>(EAsteroidSignificance::MAX)];
+
+	/** Last frame significance update time */
+	double UpdateSeconds;
+
+	/** Last frame estimated update time of all live asteroids at once */
+	double FullUpdateSeconds;
+
+	/** Work time saved by significance this and last frame, reported by significance users */
+	double SavedSeconds;
+	double LastFrameSavedSeconds;
+
+public:
+	// Sets default values for this component's properties
+	UAFPS_AsteroidSignificanceComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Check if asteroid with significance and index should be updated this frame */
+	FORCEINLINE bool ShouldUpdateThisFrame(EAsteroidSignificance Significance, int32 Index) const
+	{
+		return Significance < EAsteroidSignificance::Low ||
+			(Significance == EAsteroidSignificance::Low && (GFrameCounter + Index) % LowUpdateFrameInterval == 0) ||
+			(Significance == EAsteroidSignificance::Culled && (GFrameCounter + Index) % CulledUpdateFrameInterval == 0);
+	}
+
+	/** Check death fx budget of significance and count fx if it fits, asteroid skips its death fx otherwise */
+	bool TryAddDeathFX(EAsteroidSignificance Significance);
+
+	/** Report work time saved by skipping not significant asteroids */
+	FORCEINLINE void AddSavedSeconds(double Seconds) { SavedSeconds += Seconds; }
+
+	/** Get live asteroids num in bucket, counted on last complete update pass */
+	FORCEINLINE int32 GetBucketNum(EAsteroidSignificance Significance) const { return BucketNum[static_cast<uint8>(Significance)]; }
+
+	/** Get last frame significance update time and estimated time to update all asteroids at once */
+	FORCEINLINE double GetUpdateSeconds() const { return UpdateSeconds; }
+	FORCEINLINE double GetFullUpdateSeconds() const { return FullUpdateSeconds; }
+
+	/** Get last frame work time saved by significance */
+	FORCEINLINE double GetSavedSeconds() const { return LastFrameSavedSeconds; }
+};
@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "AFPS_AsteroidSpinSystem.h"
+#include "AFPS_AsteroidSpinComponent.generated.h"
+
+class AAFPS_Asteroid;
+
+/**
+ * Spins live asteroid actors without physics simulation, asteroid bodies are kinematic and used only for collision queries
+ * spin data is indexed same as game mode live asteroids registry
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class FPS_ASTEROID_API UAFPS_AsteroidSpinComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+	/** Live asteroids rotation and angular velocity */
+	FAsteroidSpinSystem Spin;
+
+public:
+	// Sets default values for this component's properties
+	UAFPS_AsteroidSpinComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Add asteroid spin, should be called when asteroid is added to live asteroids registry */
+	void AddAsteroid(AAFPS_Asteroid* Asteroid);
+
+	/** Swap remove asteroid spin, should be called when asteroid is swap removed from live asteroids registry */
+	void RemoveAsteroidAtSwap(int32 LiveAsteroidIndex);
+
+	/** Change asteroid angular velocity like rigid body impulse does, asteroid is treated as solid sphere */
+	void AddImpulseAtLocation(AAFPS_Asteroid* Asteroid, const FVector& Impulse, const FVector& Location);
+};
@@ -0,0 +1,134 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "AFPS_BenchmarkComponent.generated.h"
+
+class UAFPS_BenchmarkComponent;
+
+/** Ticks at end of physics to measure physics step time of benchmark frame */
+USTRUCT()
+struct FAFPS_BenchmarkEndPhysicsTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UAFPS_BenchmarkComponent* Target;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FAFPS_BenchmarkEndPhysicsTickFunction> : public TStructOpsTypeTraitsBase2<FAFPS_BenchmarkEndPhysicsTickFunction>
+{
+	enum { WithCopy = false };
+};
+
+/** Single benchmark frame sample */
+struct FAFPS_BenchmarkFrame
+{
+	int32 Wave;
+	float FrameMs;
+	float GameThreadMs;
+	float PhysicsMs;
+	int32 ActorNum;
+	int32 LiveAsteroidNum;
+	int32 HUDDrawItemNum;
+	int32 HUDQuadNum;
+	uint64 UsedPhysicalMemory;
+};
+
+/**
+ * Headless benchmark director, enabled by -AFPSBenchmark command line switch, e.g.
+ * UE4Editor FPS_Asteroid -game -nullrhi -unattended -AFPSBenchmark -BenchmarkWaves=20 -BenchmarkBaseline=Saved/Benchmark/Baseline.json
+ *
+ * kills asteroids to run waves, fires player weapon by pattern and records frames,
+ * writes per frame CSV and per wave JSON summary to -BenchmarkOut directory (Saved/Benchmark by default) and exits,
+ * exit code is 1 if requested wave isn't reached in -BenchmarkMaxSeconds
+ * or if last wave game thread time is slower than same baseline wave by more than -BenchmarkThreshold percents
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class FPS_ASTEROID_API UAFPS_BenchmarkComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+	/** Seconds between scripted asteroid kills */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark", meta = (AllowPrivateAccess = "true"))
+	float KillInterval;
+
+	/** Seconds to hold fire and to rest between fire bursts */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark", meta = (AllowPrivateAccess = "true"))
+	float FireHoldSeconds;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark", meta = (AllowPrivateAccess = "true"))
+	float FireRestSeconds;
+
+	/** Frames recorded after last wave is started */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark", meta = (AllowPrivateAccess = "true"))
+	int32 LastWaveFrames;
+
+	/** Command line params */
+	bool bBenchmarkRequested;
+	int32 WaveNum;
+	int32 Seed;
+	float MaxSeconds;
+	float ThresholdPercent;
+	FString OutDir;
+	FString BaselinePath;
+
+	/** Benchmark state */
+	bool bRunning;
+	float RunSeconds;
+	float NextKillSeconds;
+	float FireStateSeconds;
+	bool bFiring;
+	int32 LastWaveFrameCount;
+	double PhysicsStartSeconds;
+	float LastPhysicsMs;
+
+	/** Scripted kills random stream */
+	FRandomStream KillStream;
+
+	TArray<FAFPS_BenchmarkFrame> Frames;
+
+	FAFPS_BenchmarkEndPhysicsTickFunction EndPhysicsTick;
+
+public:
+	// Sets default values for this component's properties
+	UAFPS_BenchmarkComponent();
+
+	/** Check if benchmark is requested by command line, valid after BeginPlay */
+	FORCEINLINE bool IsBenchmarkRequested() const { return bBenchmarkRequested; }
+
+	/** Get asteroid spawner seed requested by command line */
+	FORCEINLINE int32 GetSeed() const { return Seed; }
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Physics step is done, called from EndPhysicsTick */
+	void OnEndPhysics();
+
+protected:
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	/** Kill one random asteroid, actor or asteroid field instance */
+	void KillRandomAsteroid();
+
+	/** Start/stop player weapon fire by pattern */
+	void UpdateFirePattern(float DeltaTime);
+
+	/** Write results, compare with baseline and request exit */
+	void FinishBenchmark();
+
+	/** Write per frame CSV, returns false on error */
+	bool WriteFramesCsv(const FString& Path) const;
+
+	/** Calculate per wave averages, written as JSON summary */
+	TSharedRef<class FJsonObject> MakeSummary() const;
+};
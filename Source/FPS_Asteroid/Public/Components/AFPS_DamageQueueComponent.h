@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "AFPS_DamageQueueComponent.generated.h"
+
+/**
+ * Single queued point damage hit, actors are weak because they can be destroyed before resolve
+ */
+struct FQueuedPointDamage
+{
+	TWeakObjectPtr<AActor> Target;
+	float Damage;
+	FVector ShotDirection;
+	FHitResult Hit;
+	TWeakObjectPtr<AController> InstigatedBy;
+	TWeakObjectPtr<AActor> DamageCauser;
+	TSubclassOf<UDamageType> DamageType;
+};
+
+/**
+ * Collects point damage hits during frame and resolves them at once in TG_PostUpdateWork
+ * hits on same target (and same instance item) are aggregated and applied by single TakeDamage call with summed damage,
+ * so damage listeners, health change and death/kill are notified once per victim instead of once per hit
+ * victim still costs OnTakeAnyDamage dynamic delegate call, so blueprint damage listeners keep working,
+ * there is no separate health pass bypassing TakeDamage
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class FPS_ASTEROID_API UAFPS_DamageQueueComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+	/** Hits queued this frame */
+	TArray<FQueuedPointDamage> QueuedHits;
+
+	/** Hits of running resolve pass, damage queued while resolving is resolved next frame */
+	TArray<FQueuedPointDamage> ResolvingHits;
+
+	/** Aggregated targets of resolve pass, kept between frames to avoid allocations */
+	TMap<TPair<AActor*, int32>, int32> TargetIndices;
+	TArray<int32> TargetLastHit;
+	TArray<float> TargetDamage;
+
+	/** Aggregated target index of each resolving hit, INDEX_NONE for destroyed targets */
+	TArray<int32> HitTargets;
+
+public:
+	// Sets default values for this component's properties
+	UAFPS_DamageQueueComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Queue point damage, same params as UGameplayStatics::ApplyPointDamage */
+	void QueuePointDamage(AActor* DamagedActor, float BaseDamage, const FVector& HitFromDirection, const FHitResult& HitInfo,
+		AController* EventInstigator, AActor* DamageCauser, TSubclassOf<UDamageType> DamageTypeClass);
+
+	/** Apply all queued damage now */
+	void ResolveQueuedDamage();
+
+	/** Get hits num waiting for resolve */
+	FORCEINLINE int32 GetQueuedHitNum() const { return QueuedHits.Num(); }
+};
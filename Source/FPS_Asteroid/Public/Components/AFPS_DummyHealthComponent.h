@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/AFPS_HealthComponent.h"
+#include "AFPS_DummyHealthComponent.generated.h"
+
+/**
+ * Health of shooting dummies, reports Dummy kill category
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class FPS_ASTEROID_API UAFPS_DummyHealthComponent : public UAFPS_HealthComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UAFPS_DummyHealthComponent();
+};
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include <FPS_Asteroid/Public/AFPS_KillEventBus.h>
 #include "AFPS_HealthComponent.generated.h"
 
 // OnHealthChanged event
@@ -24,6 +25,10 @@ class FPS_ASTEROID_API UAFPS_HealthComponent : public UActorComponent
 	UPROPERTY(BlueprintReadOnly, Category = "HealthComponent", meta = (AllowPrivateAccess = "true"))
 	bool bIsDead;
 
+	/** Owner category reported to game mode kill event bus on death, set by owner class in code */
+	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, Category = "HealthComponent", meta = (AllowPrivateAccess = "true"))
+	EKillVictimCategory KillCategory;
+
 public:	
 	// Sets default values for this component's properties
 	UAFPS_HealthComponent();
@@ -33,10 +38,11 @@ protected:
 	virtual void BeginPlay() override;
 
 public:	
+	/** Owner OnTakeAnyDamage subscriber, damage queue calls it once per victim with summed damage of frame hits */
 	UFUNCTION()
 	void HandleTakeAnyDamage(AActor* DamagedActor, float Damage, const class UDamageType* DamageType,
 		class AController* InstigatedBy, AActor* DamageCauser);
-	
+
 	/** TakeDamageResponse */
 	UPROPERTY(BlueprintAssignable, Category = "HealthComponent")
 	FOnHealthChangedSignature OnHealthChanged;
@@ -54,4 +60,10 @@ public:
 	/** Check if actor should be dead */
 	FORCEINLINE bool IsDead() const { return bIsDead; }
 
+	/** Set owner kill category, Asteroid category is allowed only for AAFPS_Asteroid owner */
+	FORCEINLINE void SetKillCategory(EKillVictimCategory InKillCategory) { KillCategory = InKillCategory; }
+
+	/** Restore default health and revive, used when owner actor is reused */
+	void ResetHealth();
+
 };